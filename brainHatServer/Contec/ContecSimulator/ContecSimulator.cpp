@@ -15,20 +15,30 @@ ifstream dataFile;
 void SimulateDeviceReadCommand();
 void SimulateDeviceStream();
 
+//  ContecSimulator [serial port] [data file]
+//  defaults to the Pi serial port and the data file in the working folder
+//  to test the server without the device, connect the simulator and the server to the two ends of a pseudo terminal pair
+//    socat -d -d pty,raw,echo=0 pty,raw,echo=0
+//
 int main(int argc, char *argv[])
 {
 	streamRunning = false;
 	
-	fd = serialOpen("/dev/serial0", 921600);
+	string portName = argc > 1 ? argv[1] : "/dev/serial0";
+	string fileName = argc > 2 ? argv[2] : "ContecDataRaw.txt";
+	
+	fd = serialOpen(portName.c_str(), 921600);
 	if (fd < 0)
 	{
+		cout << "Unable to open serial port " << portName << endl;
 		return -1;
 	}
 	
-	dataFile.open("ContecDataRaw.txt");
+	dataFile.open(fileName);
 
 	if (! dataFile.is_open())
 	{
+		cout << "Unable to open data file " << fileName << endl;
 		return -1;
 	}
 	
@@ -69,7 +79,7 @@ int main(int argc, char *argv[])
 //
 void SimulateDeviceReadCommand()
 {
-	char readBuff[2];
+	unsigned char readBuff[2];
 	
 	if (read(fd, readBuff, 2) == 2)
 	{
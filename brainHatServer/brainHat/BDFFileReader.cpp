@@ -0,0 +1,225 @@
+#include <string.h>
+#include <time.h>
+#include <EDFfile.h>
+
+#include "brainHat.h"
+#include "BDFFileReader.h"
+#include "StringExtensions.h"
+#include "BoardIds.h"
+#include "json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+
+//  Boards the writer may have recorded, found from the short sample name in the recording additional field
+//
+static const BrainhatBoardIds RecordedBoards[] =
+{
+	BrainhatBoardIds::CYTON_BOARD,
+	BrainhatBoardIds::CYTON_DAISY_BOARD,
+	BrainhatBoardIds::GANGLION_BOARD,
+	BrainhatBoardIds::MENTALIUM,
+	BrainhatBoardIds::CONTEC,
+	BrainhatBoardIds::SIGNAL_GENERATOR,
+};
+
+
+//  Constructor
+//
+BDFFileReader::BDFFileReader()
+{
+	FileHandle = -1;
+	SignalCount = 0;
+	SamplesPerDataRecord = 0;
+	ValidSignal = false;
+	StartTime = 0.0;
+}
+
+
+//  Destructor
+//
+BDFFileReader::~BDFFileReader()
+{
+	Close();
+}
+
+
+//  Open the file and read the header
+//
+bool BDFFileReader::Open(string fileName)
+{
+	Close();
+
+	FileName = fileName;
+	FileHandle = edfOpenFileReadOnly(fileName.c_str());
+	if (FileHandle < 0)
+	{
+		Logging.AddLog("BDFFileReader", "Open", format("Unable to open file %s. Error %d.", fileName.c_str(), FileHandle), LogLevelError);
+		FileHandle = -1;
+		return false;
+	}
+
+	if (!ReadHeader())
+	{
+		Logging.AddLog("BDFFileReader", "Open", format("File %s is not a brainHat recording.", fileName.c_str()), LogLevelError);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+
+//  Close the file
+//
+void BDFFileReader::Close()
+{
+	if (FileHandle >= 0)
+	{
+		edfCloseFile(FileHandle);
+		FileHandle = -1;
+	}
+}
+
+
+//  Go back to the first sample, each signal has its own position in the file
+//
+bool BDFFileReader::Rewind()
+{
+	if (FileHandle < 0)
+		return false;
+
+	for (int i = 0; i < SignalCount; i++)
+		edfRewind(FileHandle, i);
+
+	return true;
+}
+
+
+//  Read the next samples
+//  each signal is read straight into its row of the block
+//
+int BDFFileReader::ReadSamples(SampleBlock* block, int count)
+{
+	if (FileHandle < 0)
+		return 0;
+
+	int first = block->GetNumberOfSamples();
+	if (first + count > block->GetCapacity())
+		count = block->GetCapacity() - first;
+	if (count <= 0)
+		return 0;
+
+	int read = edfReadPhysicalSamples(FileHandle, 0, count, block->SampleIndexRow() + first);
+	if (read <= 0)
+		return 0;
+
+	for (int i = 1; i < block->SampleSize(); i++)
+		edfReadPhysicalSamples(FileHandle, i, read, block->Row(i) + first);
+
+	double* timeStamps = block->TimeStampRow() + first;
+	for (int i = 0; i < read; i++)
+		timeStamps[i] += StartTime;
+
+	unsigned char* validity = block->ValidityRow() + first;
+	if (ValidSignal)
+	{
+		ValidBuffer.resize(read);
+		edfReadPhysicalSamples(FileHandle, SignalCount - 1, read, ValidBuffer.data());
+		for (int i = 0; i < read; i++)
+			validity[i] = ValidBuffer[i] > 0.5 ? 1 : 0;
+	}
+	else
+	{
+		memset(validity, 1, read);
+	}
+
+	block->SetNumberOfSamples(first + read);
+
+	return read;
+}
+
+
+//  Read the header, the board and the layout of the signals the writer made
+//
+bool BDFFileReader::ReadHeader()
+{
+	int headerSize = edfGetHeaderAsJson(FileHandle, 0, NULL);
+	if (headerSize <= 0)
+		return false;
+
+	vector<char> headerBuffer(headerSize + 1, 0);
+	edfGetHeaderAsJson(FileHandle, headerSize, headerBuffer.data());
+
+	json header = json::parse(headerBuffer.data(), nullptr, false);
+	if (header.is_discarded())
+		return false;
+
+	//  signals in the writer order
+	json signals = header["signalparam"];
+	SignalCount = header["edfsignals"];
+	if (SignalCount < 2 || (int)signals.size() != SignalCount)
+		return false;
+
+	vector<string> labels;
+	for (int i = 0; i < SignalCount; i++)
+	{
+		string label = signals[i]["label"];
+		removeTrailingCharacters(label, ' ');
+		labels.push_back(label);
+	}
+
+	int signal = 0;
+	if (labels[signal++] != "SampleIndex")
+		return false;
+
+	ExgChannelCount = AccelChannelCount = OtherChannelCount = AnalogChannelCount = 0;
+	while (signal < SignalCount && labels[signal] == format("EXG%d", ExgChannelCount))
+		ExgChannelCount++, signal++;
+	while (signal < SignalCount && labels[signal] == format("Acel%d", AccelChannelCount))
+		AccelChannelCount++, signal++;
+	while (signal < SignalCount && labels[signal] == format("Other%d", OtherChannelCount))
+		OtherChannelCount++, signal++;
+	while (signal < SignalCount && labels[signal] == format("Analog%d", AnalogChannelCount))
+		AnalogChannelCount++, signal++;
+
+	if (signal >= SignalCount || labels[signal++] != "TestTime")
+		return false;
+
+	ValidSignal = signal < SignalCount && labels[signal] == "Valid";
+
+	//  sample rate from the data record, the duration is in units of 100 ns
+	SamplesPerDataRecord = signals[0]["smp_in_datarecord"];
+	long long recordDuration = header["datarecord_duration"];
+	if (SamplesPerDataRecord <= 0 || recordDuration <= 0)
+		return false;
+	SampleRate = (int)(SamplesPerDataRecord / (recordDuration * 1.0E-7) + 0.5);
+
+	//  the writer records the board short name
+	BoardId = (int)BrainhatBoardIds::UNDEFINED;
+	string recordingAdditional = header["recording_additional"];
+	removeTrailingCharacters(recordingAdditional, ' ');
+	for (auto board : RecordedBoards)
+	{
+		if (recordingAdditional == getSampleNameShort((int)board))
+			BoardId = (int)board;
+	}
+
+	//  the writer sets the start time from the local time of the first sample
+	struct tm start;
+	memset(&start, 0, sizeof(start));
+	start.tm_year = (int)header["startdate_year"] - 1900;
+	start.tm_mon = (int)header["startdate_month"] - 1;
+	start.tm_mday = header["startdate_day"];
+	start.tm_hour = header["starttime_hour"];
+	start.tm_min = header["starttime_minute"];
+	start.tm_sec = header["starttime_second"];
+	start.tm_isdst = -1;
+	long long subsecond = header["starttime_subsecond"];
+	StartTime = (double)mktime(&start) + subsecond * 1.0E-7;
+
+	Logging.AddLog("BDFFileReader", "ReadHeader", format("File %s board %d at %d Hz, %d exg channels, %lld data records.", FileName.c_str(), BoardId, SampleRate, ExgChannelCount, (long long)header["datarecords_in_file"]), LogLevelDebug);
+
+	return true;
+}
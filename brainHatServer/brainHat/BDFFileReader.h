@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "SampleFileReader.h"
+
+
+//  BDF File Reader
+//  Reads a BDF recording made by the BDFFileWriter a block of samples at a time
+//
+//  the signals in the file are in the same order as the sample block rows
+//  (SampleIndex, EXG, Acel, Other, Analog, TestTime, then the optional Valid signal),
+//  so each signal is read straight into its row, and the time stamps are the file start time plus TestTime
+//
+class BDFFileReader : public SampleFileReader
+{
+public:
+	BDFFileReader();
+	virtual ~BDFFileReader();
+
+	virtual bool Open(std::string fileName);
+	virtual void Close();
+
+	virtual bool Rewind();
+
+	virtual int ReadSamples(SampleBlock* block, int count);
+
+	//  samples in one data record of the file
+	int GetSamplesPerDataRecord() { return SamplesPerDataRecord; }
+
+protected:
+
+	int FileHandle;
+	int SignalCount;
+	int SamplesPerDataRecord;
+	bool ValidSignal;
+	double StartTime;
+
+	//  the valid signal, read before it is converted to the block validity flags
+	std::vector<double> ValidBuffer;
+
+	bool ReadHeader();
+};
@@ -12,7 +12,8 @@
 #include "BDFFileWriter.h"
 #include "StringExtensions.h"
 #include "TimeExtensions.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
+#include "SampleLayout.h"
 #include "BoardIds.h"
 #include "FileExtensions.h"
 
@@ -28,6 +29,8 @@ using namespace std;
 BDFFileWriter::BDFFileWriter(RecordingStateChangedCallbackFn fn) : BrainHatFileWriter(fn)
 {
 	FileHandle = -1;
+	DataRecord = NULL;
+	BlockFunctions = NULL;
 }
 
 
@@ -35,7 +38,8 @@ BDFFileWriter::BDFFileWriter(RecordingStateChangedCallbackFn fn) : BrainHatFileW
 //
 BDFFileWriter::~BDFFileWriter()
 {
-	
+	if (DataRecord != NULL)
+		delete DataRecord;
 }
 
 
@@ -78,30 +82,55 @@ bool BDFFileWriter::OpenFile(string fileName, bool tryUsb)
 //
 void BDFFileWriter::WriteDataToFile()
 {
-	while (SamplesQueue.size() >= SampleRate)
+	int count;
+	
+	//  take the blocks from the queue a batch at a time
+	while ((count = TakeBatch()) > 0)
 	{
-		//  get the next chunk
-		vector<BFSample*> samples;
+		for (int b = 0; b < count; b++)
 		{
-			LockMutex lockQueue(QueueMutex);
-		
-			while (samples.size() < SampleRate)
-			{
-				samples.push_back(SamplesQueue.front());
-				SamplesQueue.pop();
-			}
+			AddToDataRecord(Batch[b]);
+			Batch[b]->Release();
 		}
-				
-		WriteHeader(samples.front());
-		WriteChunk(samples);
+	}
+}
+
+
+//  Add a block to the data record, write the record out each time it has one second of data
+//
+void BDFFileWriter::AddToDataRecord(const SampleBlock* block)
+{
+	if (DataRecord == NULL)
+	{
+		DataRecord = new SampleBlock(block->GetNumberOfExgChannels(), block->GetNumberOfAccelChannels(), block->GetNumberOfOtherChannels(), block->GetNumberOfAnalogChannels(), SampleRate);
+		BlockFunctions = &GetSampleBlockFunctions(DataRecord);
+	}
 		
+	int copied = 0;
+	while (copied < block->GetNumberOfSamples())
+	{
+		int appended = BlockFunctions->Append(DataRecord, block, copied, block->GetNumberOfSamples() - copied);
+		if (appended == 0)
+		{
+			//  the block layout does not match the data record
+			Logging.AddLog("BDFFileWriter", "AddToDataRecord", format("Unable to add %d samples to the data record.", block->GetNumberOfSamples() - copied), LogLevelError);
+			break;
+		}
+		copied += appended;
+			
+		if (DataRecord->GetNumberOfSamples() == SampleRate)
+		{
+			WriteHeader(DataRecord);
+			WriteChunk(DataRecord);
+			DataRecord->SetNumberOfSamples(0);
+		}
 	}
 }
 
 
 //  Write the header to the file
 //
-void BDFFileWriter::WriteHeader(BFSample* firstSample)
+void BDFFileWriter::WriteHeader(SampleBlock* firstBlock)
 {
 	if (WroteHeader)
 		return;
@@ -109,7 +138,7 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 	{
 		LockMutex lockFile(RecordingFileMutex);
 			
-		FileHandle = edfOpenFileWriteOnly(RecordingFileFullPath.c_str(), 3, firstSample->SampleSize());
+		FileHandle = edfOpenFileWriteOnly(RecordingFileFullPath.c_str(), 3, firstBlock->SampleSize() + (ValidityChannel ? 1 : 0));
 		
 		if (FileHandle < 0)
 		{
@@ -138,7 +167,7 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 		signalCount++;
 		//
 		//  exg channels
-		for(int i = 0 ; i < firstSample->GetNumberOfExgChannels() ; i++)
+		for(int i = 0 ; i < firstBlock->GetNumberOfExgChannels() ; i++)
 		{
 			edfSetSamplesInDataRecord(FileHandle, signalCount, SampleRate);
 			edfSetPhysicalMaximum(FileHandle, signalCount, 187500.000);
@@ -151,10 +180,10 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 			edfSetPhysicalDimension(FileHandle, signalCount, "uV");
 			signalCount++;
 		}
-		NumberOfExgChannels = firstSample->GetNumberOfExgChannels();
+		NumberOfExgChannels = firstBlock->GetNumberOfExgChannels();
 		//
 		//  acel channels
-		for(int i = 0 ; i < firstSample->GetNumberOfAccelChannels() ; i++)
+		for(int i = 0 ; i < firstBlock->GetNumberOfAccelChannels() ; i++)
 		{
 			edfSetSamplesInDataRecord(FileHandle, signalCount, SampleRate);
 			edfSetPhysicalMaximum(FileHandle, signalCount, 1.0);
@@ -167,10 +196,10 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 			edfSetPhysicalDimension(FileHandle, signalCount, "unit");
 			signalCount++;
 		}
-		NumberOfAcelChannels = firstSample->GetNumberOfAccelChannels();
+		NumberOfAcelChannels = firstBlock->GetNumberOfAccelChannels();
 		//
 		//  other channels
-		for(int i = 0 ; i < firstSample->GetNumberOfOtherChannels() ; i++)
+		for(int i = 0 ; i < firstBlock->GetNumberOfOtherChannels() ; i++)
 		{
 			edfSetSamplesInDataRecord(FileHandle, signalCount, SampleRate);
 			edfSetPhysicalMaximum(FileHandle, signalCount, 9999.0);
@@ -183,10 +212,10 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 			edfSetPhysicalDimension(FileHandle, signalCount, "other");
 			signalCount++;
 		}
-		NumberOfOtherChannels = firstSample->GetNumberOfOtherChannels();
+		NumberOfOtherChannels = firstBlock->GetNumberOfOtherChannels();
 		//
 		//  analog channels
-		for(int i = 0 ; i < firstSample->GetNumberOfAnalogChannels() ; i++)
+		for(int i = 0 ; i < firstBlock->GetNumberOfAnalogChannels() ; i++)
 		{
 			edfSetSamplesInDataRecord(FileHandle, signalCount, SampleRate);
 			edfSetPhysicalMaximum(FileHandle, signalCount, 9999.0);
@@ -199,7 +228,7 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 			edfSetPhysicalDimension(FileHandle, signalCount, "analog");
 			signalCount++;
 		}
-		NumberOfAnalogChannels = firstSample->GetNumberOfAnalogChannels();
+		NumberOfAnalogChannels = firstBlock->GetNumberOfAnalogChannels();
 		//
 		//  timestamp
 		edfSetSamplesInDataRecord(FileHandle, signalCount, SampleRate);
@@ -211,13 +240,29 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 		edfSetPrefilter(FileHandle, signalCount, "");
 		edfSetTransducer(FileHandle, signalCount, "");
 		edfSetPhysicalDimension(FileHandle, signalCount, "seconds");
-		FirstTimeStamp = firstSample->TimeStamp;
+		FirstTimeStamp = firstBlock->TimeStamp(0);
+		signalCount++;
+		//
+		//  validity, 1 for samples from the board, 0 for samples filled in for a gap
+		if (ValidityChannel)
+		{
+			edfSetSamplesInDataRecord(FileHandle, signalCount, SampleRate);
+			edfSetPhysicalMaximum(FileHandle, signalCount, 1.0);
+			edfSetPhysicalMinimum(FileHandle, signalCount, 0);
+			edfSetDigitalMaximum(FileHandle, signalCount, 8388607);
+			edfSetDigitalMinimum(FileHandle, signalCount, -8388608);
+			edfSetLabel(FileHandle, signalCount, "Valid");
+			edfSetPrefilter(FileHandle, signalCount, "");
+			edfSetTransducer(FileHandle, signalCount, "");
+			edfSetPhysicalDimension(FileHandle, signalCount, "flag");
+			signalCount++;
+		}
 
-		uint32_t time_date_stamp = (uint32_t)firstSample->TimeStamp;
+		uint32_t time_date_stamp = (uint32_t)firstBlock->TimeStamp(0);
 		time_t temp = time_date_stamp;
 		tm* t = std::localtime(&temp);
 		double whole;
-		auto millis = (modf(firstSample->TimeStamp, &whole) * 1000);
+		auto millis = (modf(firstBlock->TimeStamp(0), &whole) * 1000);
 		//  File Header Properties
 		//
 		edfSetStartDatetime(FileHandle, t->tm_year+1900, t->tm_mon+1, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec);
@@ -237,86 +282,47 @@ void BDFFileWriter::WriteHeader(BFSample* firstSample)
 }
 
 
-//  Write a sample to the file
+//  Write a data record to the file
+//  the block rows are already one channel of one second of data, so they are written directly
 //
-void BDFFileWriter::WriteChunk(vector<BFSample*> chunk)
+void BDFFileWriter::WriteChunk(SampleBlock* chunk)
 {
 	{
 		LockMutex lockFile(RecordingFileMutex);
 		
-		double* row = new double[SampleRate];
-		
-		//  sample index
-		for(int j = 0 ; j < SampleRate ; j++)
-			row[j] = chunk[j]->SampleIndex;
-		auto result = edfWritePhysicalSamples(FileHandle, row);
-		if (result < 0)
+		//  all signals except the time stamp
+		for (int i = 0; i < chunk->SampleSize() - 1; i++)
 		{
-			Logging.AddLog("BDFFileWriter", "WriteChunk", format("Error writing chunk %d", result), LogLevelError);
-		}
-
-		//  EXG channels
-		for(int i = 0 ; i < NumberOfExgChannels ; i++)
-		{
-			for (int j = 0; j < SampleRate; j++)
-				row[j] = chunk[j]->GetExg(i);
-			result = edfWritePhysicalSamples(FileHandle, row);
-			if (result < 0)
-			{
-				Logging.AddLog("BDFFileWriter", "WriteChunk", format("Error writing chunk %d", result), LogLevelError);
-			}
-		}
-
-		//  Acel channels
-		for(int i = 0 ; i < NumberOfAcelChannels ; i++)
-		{
-			for (int j = 0; j < SampleRate; j++)
-				row[j] = chunk[j]->GetAccel(i);
-			result = edfWritePhysicalSamples(FileHandle, row);
+			auto result = edfWritePhysicalSamples(FileHandle, chunk->Row(i));
 			if (result < 0)
 			{
 				Logging.AddLog("BDFFileWriter", "WriteChunk", format("Error writing chunk %d", result), LogLevelError);
 			}
 		}
-
-		//  Other channels
-		for(int i = 0 ; i < NumberOfOtherChannels ; i++)
-		{
-			for (int j = 0; j < SampleRate; j++)
-				row[j] = chunk[j]->GetOther(i);
-			result = edfWritePhysicalSamples(FileHandle, row);
-			if (result < 0)
-			{
-				Logging.AddLog("BDFFileWriter", "WriteChunk", format("Error writing chunk %d", result), LogLevelError);
-			}
-		}
-
-		//  Analog channels
-		for(int i = 0 ; i < NumberOfAnalogChannels ; i++)
-		{
-			for (int j = 0; j < SampleRate; j++)
-				row[j] = chunk[j]->GetAnalog(i);
-			result = edfWritePhysicalSamples(FileHandle, row);
-			if (result < 0)
-			{
-				Logging.AddLog("BDFFileWriter", "WriteChunk", format("Error writing chunk %d", result), LogLevelError);
-			}
-		}
-
+		
 		//  Time stamp
+		double* row = chunk->TimeStampRow();
 		for(int j = 0 ; j < SampleRate ; j++)
-				row[j] = chunk[j]->TimeStamp - FirstTimeStamp;
-		result = edfWritePhysicalSamples(FileHandle, row);
+			row[j] -= FirstTimeStamp;
+		auto result = edfWritePhysicalSamples(FileHandle, row);
 		if (result < 0)
 		{
 			Logging.AddLog("BDFFileWriter", "WriteChunk", format("Error writing chunk %d", result), LogLevelError);
 		}
 		
-		delete[] row;
-		
-		for (auto it = chunk.begin(); it != chunk.end(); ++it)
+		//  Validity
+		if (ValidityChannel)
 		{
-			delete *it;
+			ValidityRecord.resize(SampleRate);
+			const unsigned char* validity = chunk->ValidityRow();
+			for (int j = 0; j < SampleRate; j++)
+				ValidityRecord[j] = validity[j];
+			
+			result = edfWritePhysicalSamples(FileHandle, ValidityRecord.data());
+			if (result < 0)
+			{
+				Logging.AddLog("BDFFileWriter", "WriteChunk", format("Error writing chunk %d", result), LogLevelError);
+			}
 		}
 	}
-}
\ No newline at end of file
+}
@@ -1,7 +1,8 @@
 #pragma once
 #include <vector>
 #include "Thread.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
+#include "SampleLayout.h"
 #include "TimeExtensions.h"
 #include "BrainHatFileWriter.h"
 
@@ -27,9 +28,15 @@ protected:
 	virtual bool OpenFile(std::string fileName, bool tryUsb);
 	virtual void CloseFile();
 	
+	//  one data record (one second) of samples waiting to be written
+	SampleBlock* DataRecord;
+	const SampleBlockFunctions* BlockFunctions;
+	std::vector<double> ValidityRecord;
+	
 	virtual void WriteDataToFile();
-	void WriteHeader(BFSample* firstSample);
-	void WriteChunk(std::vector<BFSample*> chunk);
+	void AddToDataRecord(const SampleBlock* block);
+	void WriteHeader(SampleBlock* firstBlock);
+	void WriteChunk(SampleBlock* chunk);
 	
 
 
@@ -119,7 +119,7 @@ public:
 	//  Construct from OpenBCI_GUI format text file raw data string
 	void InitializeFromText(std::string rawData)
 	{
-		Parser parser(rawData, ",");
+		FieldParser parser(rawData, ',');
 		SampleIndex = parser.GetNextDouble();
 		
 		for (int i = 0; i < ExgChannelCount; i++)
@@ -6,18 +6,34 @@
 #include <sys/time.h>
 #include <math.h>
 #include <chrono>
+#include <map>
 #include <wiringPi.h>
 
 #include "brainHat.h"
 #include "BoardDataReader.h"
 #include "StringExtensions.h"
 #include "BoardIds.h"
-#include "BFSampleImplementation.h"
+#include "SampleBlock.h"
 #include "CytonBoardConfiguration.h"
 #include "board_controller.h"
 
 #define SENSOR_SLEEP (50)
 
+//  time without samples before the board is reconnected, milliseconds
+#define DATA_TIMEOUT (1500)
+
+//  wait for the first samples after starting the stream, and how often to check, milliseconds
+#define FIRSTDATA_TIMEOUT (5000)
+#define FIRSTDATA_POLL (10)
+
+//  delay before retrying a failed connection, doubles on each failure, milliseconds
+#define RECONNECT_DELAY_MIN (250)
+#define RECONNECT_DELAY_MAX (3000)
+
+//  shortest and longest time between sample count checks in adaptive read mode, microseconds
+#define ADAPTIVE_POLL_MIN (500)
+#define ADAPTIVE_POLL_MAX (20000)
+
 using namespace std;
 using namespace chrono;
 
@@ -55,7 +71,10 @@ void BoardDataReader::Init()
 	StreamRunning = false;
 	ConnectionChangedCallback  = NULL;
 	ConnectionChangedDelegate = NULL;
-	InvalidSampleCounter = 0;
+	ReadMode = ReadFixedInterval;
+	ReadMinBatch = 1;
+	SettingsVerified = false;
+	ReconnectDelay = RECONNECT_DELAY_MIN;
 	
 	BoardDataSource::Init();
 }
@@ -78,6 +97,47 @@ bool BoardDataReader::BoardReady()
 
 
 
+//  Set the read mode
+//  minBatch is the number of samples to wait for in adaptive mode
+//
+void BoardDataReader::SetReadMode(BoardReadMode mode, int minBatch)
+{
+	ReadMode = mode;
+	ReadMinBatch = minBatch > 0 ? minBatch : 1;
+}
+
+
+//  Parse a latency vs CPU target from the command line
+//    latency  - read each sample as soon as it is available
+//    balanced - read as soon as four samples are available
+//    cpu      - read every SENSOR_SLEEP ms
+//
+bool ParseBoardReadTarget(string target, BoardReadMode& mode, int& minBatch)
+{
+	if (target == "latency")
+	{
+		mode = ReadAdaptive;
+		minBatch = 1;
+	}
+	else if (target == "balanced")
+	{
+		mode = ReadAdaptive;
+		minBatch = 4;
+	}
+	else if (target == "cpu")
+	{
+		mode = ReadFixedInterval;
+		minBatch = 1;
+	}
+	else
+	{
+		return false;
+	}
+	
+	return true;
+}
+
+
 //  Thread Start
 //
 int BoardDataReader::Start(int boardId, struct BrainFlowInputParams params, bool srb1On)
@@ -146,6 +206,49 @@ string FormatSrb1Command(CytonChannelSettings* channelSettings, bool enable)
 	return settingsString;
 }
 
+//  Coalesce the board commands queue
+//  a channel settings command replaces the earlier command for the same channel,
+//  unless another kind of command was queued between them, every other command is kept in order
+//  the earlier command is removed and the later one is sent in its own place in the queue,
+//  SRB1 is set for the whole board by every channel settings command, so the last one sent must stay last
+//
+vector<string> CoalesceBoardCommands(queue<string>& commands)
+{
+	vector<string> coalesced;
+	map<char, int> channelCommands;
+	
+	while (commands.size() > 0)
+	{
+		string nextCommand = commands.front();
+		commands.pop();
+		
+		if (IsChannelSettingsCommand(nextCommand))
+		{
+			auto previous = channelCommands.find(nextCommand[1]);
+			if (previous != channelCommands.end())
+			{
+				int removed = previous->second;
+				coalesced.erase(coalesced.begin() + removed);
+				for (auto& channel : channelCommands)
+				{
+					if (channel.second > removed)
+						channel.second--;
+				}
+			}
+			channelCommands[nextCommand[1]] = coalesced.size();
+		}
+		else
+		{
+			channelCommands.clear();
+		}
+		
+		coalesced.push_back(nextCommand);
+	}
+	
+	return coalesced;
+}
+
+
 //  Public function to set SRB1 state
 bool BoardDataReader::RequestSetSrb1(int board, bool enable)
 {
@@ -181,6 +284,33 @@ bool BoardDataReader::RequestSetSrb1(int board, bool enable)
 }
 
 
+//  Public function to queue a batch of channel settings commands
+//  the batch is applied together, with one stop of the stream
+//
+bool BoardDataReader::RequestBoardCommands(const vector<string>& commands)
+{
+	for (auto it = commands.begin(); it != commands.end(); ++it)
+	{
+		if (!IsChannelSettingsCommand(*it))
+		{
+			Logging.AddLog("BoardDataReader", "RequestBoardCommands", format("Invalid channel settings command %s.", it->c_str()), LogLevelError);
+			return false;
+		}
+	}
+	
+	if (CommandsQueueLock.try_lock_for(chrono::milliseconds(1000)))
+	{
+		for (auto it = commands.begin(); it != commands.end(); ++it)
+			CommandsQueue.push(*it);
+		
+		CommandsQueueLock.unlock();
+		return true;
+	}
+	
+	return false;
+}
+
+
 //  Public funciton to toggle streaming
 bool BoardDataReader::RequestEnableStreaming(bool enable)
 {
@@ -195,6 +325,7 @@ bool BoardDataReader::RequestEnableStreaming(bool enable)
 
 //  Initialize Board
 //  creates a new Brainflow board object and starts streaming data
+//  on a reconnect the channel settings from the last connection are sent again, and checked the next time the stream is stopped
 int BoardDataReader::InitializeBoard()
 {
 	int res = 0;
@@ -218,19 +349,30 @@ int BoardDataReader::InitializeBoard()
 		Board->prepare_session();
 		Board->config_board((char*)"s");
 		
-		if (!LoadBoardRegistersSettings())
+		if (BoardSettings.HasValidSettings())
 		{
-			Logging.AddLog("BoardDataReader", "InitializeBoard", "Failed to get board configuration.", LogLevelError);
-			if (Board->is_prepared())
+			Logging.AddLog("BoardDataReader", "InitializeBoard", "Reconnecting with the board configuration from the last connection.", LogLevelDebug);
+			SettingsVerified = false;
+			ApplyCachedBoardSettings();
+		}
+		else
+		{
+			if (!LoadBoardRegistersSettings())
 			{
-				Board->release_session();
+				Logging.AddLog("BoardDataReader", "InitializeBoard", "Failed to get board configuration.", LogLevelError);
+				if (Board->is_prepared())
+				{
+					Board->release_session();
+				}
+				return -1;
 			}
-			return -1;
+			
+			if (!InitializeSrbOnStartup())
+				return -1;
+			
+			SettingsVerified = true;
 		}
 		
-		if (!InitializeSrbOnStartup())
-			return -1;
-		
 		bool newConnection = SampleRate < 0;
 		if (newConnection)
 		{
@@ -241,6 +383,9 @@ int BoardDataReader::InitializeBoard()
 			AccelChannelCount = getNumberOfAccelChannels(BoardId);
 			OtherChannelCount = getNumberOfOtherChannels(BoardId);
 			AnalogChannelCount = getNumberOfAnalogChannels(BoardId);
+			
+			ConfigureBlockPool();
+			TimeEstimator.Configure(SampleRate, BoardId == (int)BrainhatBoardIds::CYTON_DAISY_BOARD ? 2 : 1);
 		}
 		
 		ConnectionChanged(newConnection ? New : Connected, BoardId, SampleRate);
@@ -249,12 +394,16 @@ int BoardDataReader::InitializeBoard()
 		
 		InitializeDataReadCounters();
 		
-		usleep(5 * USLEEP_SEC);
-
+		if (!WaitForFirstData())
+		{
+			Logging.AddLog("BoardDataReader", "InitializeBoard", "No data from board after starting stream.", LogLevelDebug);
+			ReleaseBoard();
+			return -1;
+		}
 		
-		DiscardFirstChunk();
+		ValidDataTimer.Start();
 		IsConnected = true;
-		Logging.AddLog("BoardDataReader", "InitializeBoard", format("Connected to board %d. Sample rate %d", BoardId, SampleRate), LogLevelInfo);
+		Logging.AddLog("BoardDataReader", "InitializeBoard", format("Connected to board %d. Sample rate %d. %s", BoardId, SampleRate, ReadMode == ReadAdaptive ? format("Reading batches of %d samples.", ReadMinBatch).c_str() : "Reading at fixed interval."), LogLevelInfo);
 	}
 	catch (const BrainFlowException &err)
 	{
@@ -324,14 +473,73 @@ bool BoardDataReader::InitializeSrbOnStartup()
 
 
 
+//  Send every channel setting from the last connection, in case the board was reset
+//  the commands are the same channel settings commands a channelset request sends, so the board is left in the cached state,
+//  the registers are read back the next time the stream is stopped
+//
+void BoardDataReader::ApplyCachedBoardSettings()
+{
+	int sent = 0;
+	for (auto board = BoardSettings.Boards.begin(); board != BoardSettings.Boards.end(); ++board)
+	{
+		for (auto channel = (*board)->Channels.begin(); channel != (*board)->Channels.end(); ++channel)
+		{
+			Board->config_board((char*)FormatSrb1Command(*channel, (*board)->Srb1Set).c_str());
+			sent++;
+		}
+	}
+	
+	Logging.AddLog("BoardDataReader", "ApplyCachedBoardSettings", format("Sent %d cached channel settings.", sent), LogLevelDebug);
+}
+
+
+//  Wait for the first samples after the stream is started, and discard them
+//
+bool BoardDataReader::WaitForFirstData()
+{
+	ChronoTimer waitTimer;
+	waitTimer.Start();
+	
+	while (ThreadRunning && waitTimer.ElapsedMilliseconds() < FIRSTDATA_TIMEOUT)
+	{
+		if (Board->get_board_data_count() > 0)
+		{
+			DiscardFirstChunk();
+			return true;
+		}
+		usleep(FIRSTDATA_POLL * USLEEP_MILI);
+	}
+	
+	return false;
+}
+
+
+//  Read the board registers if the settings from the last connection were not checked
+//  only called with the stream stopped
+//
+void BoardDataReader::VerifyBoardSettings()
+{
+	if (SettingsVerified)
+		return;
+	
+	if (LoadBoardRegistersSettings())
+		SettingsVerified = true;
+	else
+		Logging.AddLog("BoardDataReader", "VerifyBoardSettings", "Failed to get board configuration.", LogLevelError);
+}
+
+
 // Initialize the data reading monitor counters
 //
 void BoardDataReader::InitializeDataReadCounters()
 {
 	LastSampleIndex = -1;
 	LastTimeStampSync = -1;
+	TimeEstimator.Reset();
+	ResetGapDetection();
 	ReadTimer.Start();
 	InspectDataStreamLogTimer.Start(); 
+	TimeEstimatorLogTimer.Start();
 }
 
 
@@ -357,7 +565,6 @@ void BoardDataReader::ReleaseBoard()
 		
 		delete Board;
 		Board = NULL;
-		InvalidSampleCounter = 0;
 		ConnectionChanged(Disconnected, BoardId, SampleRate);
 	}
 	
@@ -386,6 +593,7 @@ void BoardDataReader::StartStreaming()
 			}
 			
 			StreamRunning = true;
+			ValidDataTimer.Reset();
 			ConnectionChanged(StreamOn, BoardId, SampleRate);
 		}
 		catch (const BrainFlowException &err)
@@ -419,14 +627,21 @@ void BoardDataReader::StopStreaming()
 
 
 //  Reconnect to Board
-//  tries to restart board streaming
+//  tries to restart board streaming, waiting longer after each failure
 //
 void BoardDataReader::EstablishConnectionWithBoard()
 {
 	if (!BoardReady())
 	{
 		if (InitializeBoard() != 0)
-			usleep(3*USLEEP_SEC);
+		{
+			usleep(ReconnectDelay * USLEEP_MILI);
+			ReconnectDelay = ReconnectDelay * 2 < RECONNECT_DELAY_MAX ? ReconnectDelay * 2 : RECONNECT_DELAY_MAX;
+		}
+		else
+		{
+			ReconnectDelay = RECONNECT_DELAY_MIN;
+		}
 	}
 }
 	
@@ -466,15 +681,16 @@ bool BoardDataReader::PreparedToReadBoard()
 	}
 	else if (!StreamRunning)
 	{
+		VerifyBoardSettings();
 		usleep(1*USLEEP_SEC);
 		return false;
 	}
-	else if ((InvalidSampleCounter * SENSOR_SLEEP) > 3000)
+	else if (ValidDataTimer.ElapsedMilliseconds() > DATA_TIMEOUT)
 	{
-		//  have not received fresh samples in three seconds, release board and reinitialize
+		//  have not received fresh samples, release board and reinitialize
 		Logging.AddLog("BoardDataReader", "PreparedToReadBoard", "Too long without valid sample. Reconnecting to board.", LogLevelError);
+		ReconnectStarted(ValidDataTimer.ElapsedMilliseconds());
 		ReleaseBoard();
-		usleep(1*USLEEP_SEC);
 		return false;
 	}
 	
@@ -486,10 +702,6 @@ bool BoardDataReader::PreparedToReadBoard()
 //
 void BoardDataReader::RunFunction()
 {
-	double **chunk = NULL;
-	int res = 0;
-	int sampleCount = 0;
-	
 	while (ThreadRunning)
 	{
 		try
@@ -497,91 +709,115 @@ void BoardDataReader::RunFunction()
 			if (!PreparedToReadBoard())
 				continue;
 			
-			//  read at our specified interval
-			if(ReadTimer.ElapsedMilliseconds() > SENSOR_SLEEP)
-			{
-				ReadTimer.Reset();
-					
-				auto chunk = Board->get_board_data();
-				ProcessData(chunk);
-			}
-		
-			usleep(1*USLEEP_MILI);	
+			if (ReadMode == ReadAdaptive)
+				ReadAdaptiveData();
+			else
+				ReadFixedIntervalData();
 		}
 		catch (const BrainFlowException &err)
 		{
 			Logging.AddLog("BoardDataReader", "RunFunction", err.what(), LogLevelError);
+			ReconnectStarted(ValidDataTimer.ElapsedMilliseconds());
 			ReleaseBoard();
-			usleep(3*USLEEP_SEC);
 		}
 	}
 }
 
 
+//  Read everything available at the fixed interval
+//  sleeps until the next read is due
+//
+void BoardDataReader::ReadFixedIntervalData()
+{
+	int elapsed = ReadTimer.ElapsedMilliseconds();
+	if (elapsed < SENSOR_SLEEP)
+	{
+		usleep((SENSOR_SLEEP - elapsed) * USLEEP_MILI);
+		return;
+	}
+	
+	ReadTimer.Reset();
+	
+	auto chunk = Board->get_board_data();
+	ProcessData(chunk);
+}
+
+
+//  Read as soon as the minimum batch of samples is available
+//  sleeps for about the time it will take the board to produce the rest of the batch
+//
+void BoardDataReader::ReadAdaptiveData()
+{
+	int available = Board->get_board_data_count();
+	if (available >= ReadMinBatch)
+	{
+		auto chunk = Board->get_board_data();
+		ProcessData(chunk);
+		available = 0;
+	}
+	
+	int wait = ((ReadMinBatch - available) * USLEEP_SEC) / SampleRate;
+	if (wait < ADAPTIVE_POLL_MIN)
+		wait = ADAPTIVE_POLL_MIN;
+	else if (wait > ADAPTIVE_POLL_MAX)
+		wait = ADAPTIVE_POLL_MAX;
+	
+	usleep(wait);
+}
+
+
 // Process a chunk of data read from the board
 // send to broadcast thread and logging if enabled
 //
 void BoardDataReader::ProcessData(BrainFlowArray<double,2>& chunk)
 {	
-	//  'improve' the time stamp to be more accurate
-	double period, oldestSampleTime;
-	CalculateReadingTimeThisChunk(chunk, period, oldestSampleTime);
-	
-	//  count the epochs where we have no data, will trigger a reconnect eventually		
+	//  no data, if this goes on too long it will trigger a reconnect
 	if(chunk.get_size(1) == 0)
-		InvalidSampleCounter++;
-	else
-		InvalidSampleCounter = 0;
+		return;
 	
-	for (int i = 0; i < chunk.get_size(1); i++)
-	{
-		BFSample* sample = ParseRawData(chunk, i);
+	ValidDataTimer.Reset();
+	ReconnectFinished();
 	
-		//  fix the time stamp
-		sample->TimeStamp = oldestSampleTime + ((i + 1)*period);
-				
-		//  inspect data stream
-		InspectDataStream(sample);
-		
-		//  notify new sample
-		NewSampleCallback(sample);
-	}
+	SampleBlock* block = ParseRawData(chunk);
+	
+	//  find gaps in the sample index, filling them if enabled
+	block = DetectGaps(block);
+	
+	//  sample times from the fit of the sample index to the clock
+	TimeEstimator.AddChunk(block->SampleIndexRow(), block->GetNumberOfSamples(), block->TimeStampRow());
+	LogTimeEstimator();
+	
+	ReportGaps(block);
+	
+	//  inspect data stream
+	InspectDataStream(block);
+	
+	//  publish the block, consumers hold their own references
+	NewSample(block);
+	block->Release();
 }
 
 
 
-//  Parse the raw data and create a sample type for this board
+//  Parse the raw data into a sample block for this board
 //
-BFSample* BoardDataReader::ParseRawData(BrainFlowArray<double,2>& chunk, int sampleIndex)
+SampleBlock* BoardDataReader::ParseRawData(BrainFlowArray<double,2>& chunk)
 {
-	auto newSample = new Sample(ExgChannelCount, AccelChannelCount, OtherChannelCount, AnalogChannelCount);
-	newSample->InitializeFromChunk(chunk, sampleIndex);
-	return newSample;
+	auto newBlock = BlockPool.Get(chunk.get_size(1));
+	newBlock->InitializeFromChunk(chunk);
+	return newBlock;
 }
 
 
-//  Calculate the reading time this chunk
-//  used to smooth out the sample times
+//  Log the sample time fit
 //
-void BoardDataReader::CalculateReadingTimeThisChunk(BrainFlowArray<double,2>& chunk, double& period, double& oldestSampleTime)
+void BoardDataReader::LogTimeEstimator()
 {
-	int samples = chunk.get_size(1);
-	
-	auto timeNow = (chrono::duration_cast< milliseconds >(system_clock::now().time_since_epoch()).count() / 1000.0);	
-		
-	if (LastTimeStampSync > 0)
-	{
-		oldestSampleTime = LastTimeStampSync;
-	}
-	else
-	{
-		oldestSampleTime = timeNow - (samples / SampleRate);
-	}
-	
-	LastTimeStampSync = timeNow;
-		
-	period = (timeNow - oldestSampleTime) / samples;
+	if (TimeEstimatorLogTimer.ElapsedMilliseconds() < 5000)
+		return;
 	
+	TimeEstimatorLogTimer.Reset();
+	Logging.AddLog("BoardDataReader", "LogTimeEstimator", format("Sample clock drift %.1lf ppm, read jitter %.1lf ms, %d reads in fit, %d anchors.", TimeEstimator.GetDriftPpm(), TimeEstimator.GetResidual() * 1000.0, TimeEstimator.GetWindowSize(), TimeEstimator.GetNumberOfAnchors()), LogLevelTrace);
 }
 
 
@@ -613,16 +849,23 @@ void BoardDataReader::ProcessCommandsQueue()
 		
 			BoardSettings.ClearBoards();
 		
-			while (CommandsQueue.size() != 0) 
+			ChronoTimer commandsTimer;
+			commandsTimer.Start();
+			
+			//  config_board returns when the board has answered, so each command follows the last without a fixed delay
+			int queued = CommandsQueue.size();
+			auto commands = CoalesceBoardCommands(CommandsQueue);
+			for (auto it = commands.begin(); it != commands.end(); ++it)
 			{
-				string nextCommand = CommandsQueue.front();
-				CommandsQueue.pop();
-				Logging.AddLog("BoardDataReader", "ProcessCommandsQueue", format("Send to board: %s", nextCommand.c_str()), LogLevelInfo);
-				Board->config_board((char*)nextCommand.c_str());
-				usleep(50*USLEEP_MILI);
+				Logging.AddLog("BoardDataReader", "ProcessCommandsQueue", format("Send to board: %s", it->c_str()), LogLevelDebug);
+				Board->config_board((char*)it->c_str());
 			}
 		
-			if (!LoadBoardRegistersSettings())
+			if (LoadBoardRegistersSettings())
+			{
+				SettingsVerified = true;
+			}
+			else
 			{
 				Logging.AddLog("BoardDataReader", "ProcessCommandsQueue", "Error restoring board configuration.", LogLevelError);
 			}
@@ -631,12 +874,15 @@ void BoardDataReader::ProcessCommandsQueue()
 			{
 				StartStreaming();
 			}
+			
+			Logging.AddLog("BoardDataReader", "ProcessCommandsQueue", format("Sent %d commands (%d queued) in %d ms.", (int)commands.size(), queued, commandsTimer.ElapsedMilliseconds()), LogLevelInfo);
 		
 			CommandsQueueLock.unlock();
 		}
 	}
 	catch (const BrainFlowException &err)
 	{
+		CommandsQueueLock.unlock();
 		Logging.AddLog("BoardDataReader", "ProcessCommandsQueue", format("Failed configure_board. Error %d %s.", err.exit_code, err.what()), LogLevelError);
 	}
 }
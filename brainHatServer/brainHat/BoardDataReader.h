@@ -3,13 +3,34 @@
 #include <string>
 #include <chrono>
 #include <list>
+#include <queue>
+#include <vector>
 #include <functional>
 
 #include "BoardDataSource.h"
 #include "board_shim.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
 #include "TimeExtensions.h"
 #include "CytonBoardSettings.h"
+#include "SampleTimeEstimator.h"
+
+
+//  Board read modes
+//
+typedef enum
+{
+	ReadFixedInterval,	//  read whatever is available every SENSOR_SLEEP ms, lowest CPU use
+	ReadAdaptive,		//  poll the available sample count, and read as soon as the minimum batch is available, lowest latency
+} BoardReadMode;
+
+//  latency vs CPU targets for the command line
+bool ParseBoardReadTarget(std::string target, BoardReadMode& mode, int& minBatch);
+
+//  the channel settings command that sets SRB1 for the board the channel is on
+std::string FormatSrb1Command(CytonChannelSettings* channelSettings, bool enable);
+
+//  take the queued board commands, dropping channel settings commands replaced by a later command for the same channel
+std::vector<std::string> CoalesceBoardCommands(std::queue<std::string>& commands);
 
 
 class BoardDataReader : public BoardDataSource
@@ -20,6 +41,9 @@ public:
 	
 	virtual int Start(int boardId, struct BrainFlowInputParams params, bool srb1On);
 	
+	//  set how the board is read, call before Start()
+	void SetReadMode(BoardReadMode mode, int minBatch);
+	
 	virtual void Cancel();
 	
 	virtual void RunFunction();
@@ -31,6 +55,7 @@ public:
 	
 	virtual bool RequestSetSrb1(int board, bool enable);
 	virtual bool RequestEnableStreaming(bool enable);
+	virtual bool RequestBoardCommands(const std::vector<std::string>& commands);
 	
 protected:
 	
@@ -49,6 +74,8 @@ protected:
 	bool BoardReady();
 	int	 InitializeBoard();
 	bool InitializeSrbOnStartup();
+	void ApplyCachedBoardSettings();
+	bool WaitForFirstData();
 	void InitializeDataReadCounters();
 	void ReleaseBoard();
 	void DiscardFirstChunk();
@@ -56,14 +83,23 @@ protected:
 	void StopStreaming();
 	
 	//  Run function reading loop
+	BoardReadMode ReadMode;
+	int ReadMinBatch;
 	ChronoTimer ReadTimer;
-	int InvalidSampleCounter;
+	ChronoTimer ValidDataTimer;
+	int ReconnectDelay;
 	//
+	void ReadFixedIntervalData();
+	void ReadAdaptiveData();
 	void EstablishConnectionWithBoard();
 	bool PreparedToReadBoard();
 	void ProcessData(BrainFlowArray<double,2>& chunk);
-	BFSample* ParseRawData(BrainFlowArray<double, 2>& chunk, int sample);
-	void CalculateReadingTimeThisChunk(BrainFlowArray<double, 2>& chunk, double& period, double& oldestSampleTime);
+	SampleBlock* ParseRawData(BrainFlowArray<double, 2>& chunk);
+	
+	//  sample times from the sample index
+	SampleTimeEstimator TimeEstimator;
+	ChronoTimer TimeEstimatorLogTimer;
+	void LogTimeEstimator();
 	
 	
 	//  Board hardware settings and configuration commands
@@ -76,6 +112,10 @@ protected:
 	bool ValidateRegisterSettingsString(std::string registerSettings);
 	bool ValidateFirmwareString(std::string firmware);	
 	CytonBoards BoardSettings;
+	//
+	//  the settings are from the last connection and have not been read back from the board since the reconnect
+	bool SettingsVerified;
+	void VerifyBoardSettings();
 	
 
 };
\ No newline at end of file
@@ -17,6 +17,42 @@
 using namespace std;
 using namespace chrono;
 
+
+//  Gap fill names
+//
+string SampleGapFillName(SampleGapFill fill)
+{
+	switch (fill)
+	{
+	case GapFillNone:
+		return "none";
+	case GapFillNaN:
+		return "nan";
+	case GapFillInterpolate:
+		return "interpolate";
+	default:
+		return "unknown";
+	}
+}
+
+
+//  Parse a gap fill name
+//
+bool ParseSampleGapFill(string name, SampleGapFill& fill)
+{
+	for (int i = GapFillNone; i <= GapFillInterpolate; i++)
+	{
+		if (name == SampleGapFillName((SampleGapFill)i))
+		{
+			fill = (SampleGapFill)i;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
 //  Board Data Source
 //  Base class for board data reader and board file simulator
 //
@@ -25,6 +61,9 @@ BoardDataSource::BoardDataSource()
 	ConnectionChangedCallback = NULL;
 	ConnectionChangedDelegate = NULL;
 	NewSampleCallback = NULL;
+	NewSampleDelegate = NULL;
+	SampleGapDelegate = NULL;
+	GapFill = GapFillNone;
 	
 	Init();
 }
@@ -49,6 +88,43 @@ void BoardDataSource::Init()
 	
 	NumberOfSamplesCounted = 0;
 	InspectDataStreamLogTimer.Start();
+	
+	GapCount = 0;
+	GapLostSamples = 0;
+	ResetGapDetection();
+	
+	Reconnects = 0;
+	LastReconnectSeconds = 0.0;
+	Reconnecting = false;
+	ReconnectLostMilliseconds = 0;
+}
+
+
+//  The data stopped and the board is being reconnected, start timing the reconnect
+//
+void BoardDataSource::ReconnectStarted(int millisecondsWithoutData)
+{
+	if (Reconnecting)
+		return;
+	
+	Reconnecting = true;
+	ReconnectLostMilliseconds = millisecondsWithoutData;
+	ReconnectTimer.Start();
+}
+
+
+//  The first sample after a reconnect was read, log the time without data
+//
+void BoardDataSource::ReconnectFinished()
+{
+	if (!Reconnecting)
+		return;
+	
+	Reconnecting = false;
+	Reconnects++;
+	LastReconnectSeconds = (ReconnectLostMilliseconds / 1000.0) + ReconnectTimer.ElapsedSeconds();
+	
+	Logging.AddLog("BoardDataSource", "ReconnectFinished", format("Reconnected to board %d. No data for %.2lf seconds. %d reconnects.", BoardId, LastReconnectSeconds, Reconnects), LogLevelInfo);
 }
 
 
@@ -68,6 +144,14 @@ void BoardDataSource::RegisterConnectionChangedDelegate(ConnectionChangedDelegat
 }
 
 
+//  Regiter a C++ new sample callback
+//
+void BoardDataSource::RegisterNewSampleDelegate(NewSampleDelegateFn newSampleDel)
+{
+	NewSampleDelegate = newSampleDel;
+}
+
+
 //  Board connection properties changed
 //
 void BoardDataSource::ConnectionChanged(BoardConnectionStates state, int boardId, int sampleRate)
@@ -79,6 +163,26 @@ void BoardDataSource::ConnectionChanged(BoardConnectionStates state, int boardId
 }
 
 
+//  New block of samples from the source
+//
+void BoardDataSource::NewSample(const SampleBlock* block)
+{
+	if (NewSampleCallback != NULL)
+		NewSampleCallback(block);
+	if (NewSampleDelegate != NULL)
+		NewSampleDelegate(block);
+}
+
+
+//  Set how gaps in the sample index are handled
+//
+void BoardDataSource::SetGapFill(SampleGapFill fill, SampleGapDelegateFn gapDel)
+{
+	GapFill = fill;
+	SampleGapDelegate = gapDel;
+}
+
+
 //  Enable or disable the board
 //  will signal the main program to take action required (such as turn on power to the board)
 //
@@ -99,11 +203,13 @@ void BoardDataSource::EnableBoard(bool enable)
 
 //  Inspect the data stream and report statistics on a regular basis
 //
-void BoardDataSource::InspectDataStream(BFSample* data)
+void BoardDataSource::InspectDataStream(const SampleBlock* data)
 {
-	//DataInspecting.push_back(data->Copy());
-	NumberOfSamplesCounted++;
-	InspectSampleIndexDifference(data->SampleIndex);
+	NumberOfSamplesCounted += data->GetNumberOfSamples();
+	
+	const double* sampleIndex = data->SampleIndexRow();
+	for (int i = 0; i < data->GetNumberOfSamples(); i++)
+		InspectSampleIndexDifference(sampleIndex[i]);
 	
 	//  log data stream inspection every five seconds
 	if(InspectDataStreamLogTimer.ElapsedMilliseconds() > 5000)
@@ -113,15 +219,42 @@ void BoardDataSource::InspectDataStream(BFSample* data)
 		InspectDataStreamLogTimer.Reset();
 		NumberOfSamplesCounted = 0;
 	
-		if (CountMissingIndex > 0)
+		if (BlockPool.IsConfigured())
+		{
+			Logging.AddLog("BoardDataSource", "InspectDataStream", format("Block pool hits %d misses %d high water %d of %d.", BlockPool.GetHits(), BlockPool.GetMisses(), BlockPool.GetHighWaterMark(), BlockPool.GetPoolSize()), LogLevelTrace);
+		}
+	
+		if (GapCount > 0)
+		{
+			Logging.AddLog("BoardDataSource", "InspectDataStream", format("Lost %d samples in %d gaps in the last 5 seconds.%s", GapLostSamples, GapCount, GapFill == GapFillNone ? "" : format(" Filled with %s samples.", SampleGapFillName(GapFill).c_str()).c_str()), LogLevelWarn);
+			GapCount = 0;
+			GapLostSamples = 0;
+		}
+		else if (CountMissingIndex > 0)
 		{
 			Logging.AddLog("BoardDataSource", "InspectDataStream", format("Missed %d samples in the last 5 seconds.", CountMissingIndex), LogLevelWarn);
-			CountMissingIndex = 0;
 		}
+		CountMissingIndex = 0;
 	}
 }
 
 
+//  Size the sample block pool for the board layout
+//  blocks hold a quarter second of data, which covers a normal read,
+//  and the pool holds enough blocks for every consumer to fall a few seconds behind before it needs to allocate
+//
+void BoardDataSource::ConfigureBlockPool()
+{
+	int blockCapacity = SampleRate > 0 ? SampleRate / 4 : 1;
+	if (blockCapacity < 16)
+		blockCapacity = 16;
+	
+	BlockPool.Configure(ExgChannelCount, AccelChannelCount, OtherChannelCount, AnalogChannelCount, blockCapacity, SAMPLEBLOCK_POOLSIZE);
+	
+	Logging.AddLog("BoardDataSource", "ConfigureBlockPool", format("Block pool %d blocks of %d samples.", SAMPLEBLOCK_POOLSIZE, blockCapacity), LogLevelDebug);
+}
+
+
 //  Get the sample index difference accounting for roll over
 //
 int BoardDataSource::SampleIndexDifference(double nextIndex)
@@ -171,4 +304,169 @@ void BoardDataSource::InspectSampleIndexDifference(double nextIndex)
 		break;
 		
 	}
-}
\ No newline at end of file
+}
+
+
+//  Sample index step between samples for gap detection
+//  zero if the board sample index can not be used to find gaps
+//
+int BoardDataSource::GapIndexStep()
+{
+	switch ((BrainhatBoardIds)BoardId)
+	{
+	case BrainhatBoardIds::CYTON_BOARD:
+	case BrainhatBoardIds::MENTALIUM:
+		return 1;
+		
+	case BrainhatBoardIds::CYTON_DAISY_BOARD:
+		return 2;
+		
+	default:
+		return 0;
+	}
+}
+
+
+//  Forget the last sample, the next block starts fresh
+//
+void BoardDataSource::ResetGapDetection()
+{
+	GapLastIndex = -1;
+	GapLastTimeStamp = 0.0;
+	GapLastSample.clear();
+	Gaps.clear();
+}
+
+
+//  Find the gaps in a block from the sample index
+//  returns the block, or a new block with the gaps filled (the block passed in is released)
+//  the gaps found are kept for ReportGaps() once the block has its time stamps
+//
+SampleBlock* BoardDataSource::DetectGaps(SampleBlock* block)
+{
+	Gaps.clear();
+	
+	int step = GapIndexStep();
+	int samples = block->GetNumberOfSamples();
+	if (step == 0 || samples == 0)
+		return block;
+	
+	const double* sampleIndex = block->SampleIndexRow();
+	int lostSamples = 0;
+	for (int i = 0; i < samples; i++)
+	{
+		if (GapLastIndex >= 0)
+		{
+			int difference = ((int)sampleIndex[i] - (int)GapLastIndex + 256) % 256;
+			int lost = ((difference + (step / 2)) / step) - 1;
+			if (lost > 0)
+			{
+				SampleGap gap;
+				gap.BoardId = BoardId;
+				gap.LostSamples = lost;
+				gap.Filled = false;
+				gap.StartTime = 0.0;
+				gap.EndTime = 0.0;
+				gap.Position = i;
+				Gaps.push_back(gap);
+				
+				lostSamples += lost;
+			}
+		}
+		GapLastIndex = sampleIndex[i];
+	}
+	
+	if (lostSamples > 0 && GapFill != GapFillNone)
+		block = FillGaps(block, lostSamples);
+	
+	//  keep the last sample to interpolate a gap at the start of the next block
+	GapLastSample.resize(block->SampleSize());
+	for (int r = 0; r < block->SampleSize(); r++)
+		GapLastSample[r] = block->Row(r)[block->GetNumberOfSamples() - 1];
+	
+	return block;
+}
+
+
+//  Make a new block with the lost samples added, flagged invalid
+//  the time stamps of the filled samples are set by the data source along with the rest of the block
+//
+SampleBlock* BoardDataSource::FillGaps(SampleBlock* block, int lostSamples)
+{
+	int samples = block->GetNumberOfSamples();
+	int rows = block->SampleSize();
+	int step = GapIndexStep();
+	
+	SampleBlock* filled = BlockPool.Get(samples + lostSamples);
+	filled->SetNumberOfSamples(samples + lostSamples);
+	
+	unsigned char* validity = filled->ValidityRow();
+	int out = 0;
+	size_t nextGap = 0;
+	for (int i = 0; i < samples; i++)
+	{
+		if (nextGap < Gaps.size() && Gaps[nextGap].Position == i)
+		{
+			//  the sample before the gap is the last sample copied, or the last sample of the previous block
+			int lost = Gaps[nextGap].LostSamples;
+			int before = out - 1;
+			for (int k = 1; k <= lost; k++)
+			{
+				double fraction = (double)k / (lost + 1);
+				for (int r = 0; r < rows - 1; r++)
+				{
+					double first = before >= 0 ? filled->Row(r)[before] : GapLastSample[r];
+					if (r == 0)
+						filled->Row(r)[out] = fmod(first + (k * step), 256);
+					else if (GapFill == GapFillNaN)
+						filled->Row(r)[out] = NAN;
+					else
+						filled->Row(r)[out] = first + ((block->Row(r)[i] - first) * fraction);
+				}
+				filled->TimeStampRow()[out] = block->TimeStamp(i);
+				validity[out] = 0;
+				out++;
+			}
+			
+			Gaps[nextGap].Position = out;
+			Gaps[nextGap].Filled = true;
+			nextGap++;
+		}
+		
+		for (int r = 0; r < rows; r++)
+			filled->Row(r)[out] = block->Row(r)[i];
+		validity[out] = block->ValidityRow()[i];
+		out++;
+	}
+	
+	block->Release();
+	return filled;
+}
+
+
+//  Report the gaps found in the last block, now that it has its time stamps
+//
+void BoardDataSource::ReportGaps(const SampleBlock* block)
+{
+	int samples = block->GetNumberOfSamples();
+	if (samples == 0)
+		return;
+	
+	const double* timeStamps = block->TimeStampRow();
+	for (auto it = Gaps.begin(); it != Gaps.end(); ++it)
+	{
+		int before = it->Position - (it->Filled ? it->LostSamples : 0) - 1;
+		it->StartTime = before >= 0 ? timeStamps[before] : GapLastTimeStamp;
+		it->EndTime = timeStamps[it->Position];
+		
+		GapCount++;
+		GapLostSamples += it->LostSamples;
+		
+		Logging.AddLog("BoardDataSource", "ReportGaps", format("Lost %d samples between %.3lf and %.3lf.", it->LostSamples, it->StartTime, it->EndTime), LogLevelDebug);
+		
+		if (SampleGapDelegate != NULL)
+			SampleGapDelegate(*it);
+	}
+	
+	GapLastTimeStamp = timeStamps[samples - 1];
+}
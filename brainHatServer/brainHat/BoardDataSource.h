@@ -5,11 +5,17 @@
 #include <chrono>
 #include <list>
 #include <functional>
+#include <vector>
 
 #include "Thread.h"
 #include "board_shim.h"
 #include "BFSample.h"
+#include "SampleBlock.h"
 #include "TimeExtensions.h"
+#include "json.hpp"
+
+//  Number of blocks in the sample block pool
+#define SAMPLEBLOCK_POOLSIZE (128)
 
 //  Board connection states
 enum BoardConnectionStates
@@ -30,7 +36,59 @@ typedef void(*ConnectionChangedCallbackFn)(BoardConnectionStates, int, int);
 //  callback function C++ class
 typedef std::function<void(BoardConnectionStates, int, int)> ConnectionChangedDelegateFn;
 
-typedef void(*NewSampleCallbackFn)(BFSample* sample);
+//  New sample block event
+//  callback function for C code
+typedef void(*NewSampleCallbackFn)(const SampleBlock* block);
+//  callback function C++ class
+typedef std::function<void(const SampleBlock*)> NewSampleDelegateFn;
+
+
+//  What to do with samples lost by the board (radio drop outs)
+//
+typedef enum
+{
+	GapFillNone,		//  gaps are reported, no samples are added
+	GapFillNaN,			//  lost samples are replaced by NaN samples, flagged invalid
+	GapFillInterpolate,	//  lost samples are interpolated between the samples either side of the gap, flagged invalid
+} SampleGapFill;
+
+std::string SampleGapFillName(SampleGapFill fill);
+bool ParseSampleGapFill(std::string name, SampleGapFill& fill);
+
+
+//  A gap in the sample stream
+//  the lost samples were between the last sample before the gap and the first sample after it
+//
+struct SampleGap
+{
+public:
+	int BoardId;
+	int LostSamples;
+	bool Filled;
+	
+	//  time stamps of the samples either side of the gap
+	double StartTime;
+	double EndTime;
+	
+	//  position of the first sample after the gap in the block
+	int Position;
+	
+	nlohmann::json AsJson() const
+	{
+		nlohmann::json j;
+		
+		j["BoardId"] = BoardId;
+		j["LostSamples"] = LostSamples;
+		j["Filled"] = Filled;
+		j["StartTime"] = StartTime;
+		j["EndTime"] = EndTime;
+		
+		return j;
+	}
+};
+
+//  Sample gap event
+typedef std::function<void(const SampleGap&)> SampleGapDelegateFn;
 
 
 class BoardDataSource : public Thread
@@ -43,6 +101,7 @@ public:
 	virtual int Start(int boardId, struct BrainFlowInputParams params, bool srb1On) = 0;
 	
 	void RegisterConnectionChangedDelegate(ConnectionChangedDelegateFn connectionChangedDel);
+	void RegisterNewSampleDelegate(NewSampleDelegateFn newSampleDel);
 	
 	bool GetIsConnected() { return IsConnected;}
 		
@@ -51,14 +110,28 @@ public:
 	
 	int GetBoardId() { return BoardId; }
 	int GetSampleRate() { return SampleRate; }
+	int GetNumberOfExgChannels() { return ExgChannelCount; }
+	int GetNumberOfAccelChannels() { return AccelChannelCount; }
+	int GetNumberOfOtherChannels() { return OtherChannelCount; }
+	int GetNumberOfAnalogChannels() { return AnalogChannelCount; }
 	
 	virtual int GetSrb1(int board) { return -1;	}
 	virtual bool GetIsStreamRunning() { return StreamRunning;}
 	
 	virtual bool RequestSetSrb1(int board, bool enable) { return false;}
 	virtual bool RequestEnableStreaming(bool enable) { return false;}
+	virtual bool RequestBoardCommands(const std::vector<std::string>& commands) { return false;}
 	
 	virtual void EnableRawConsole(bool enable) { return ;}
+	
+	//  set how gaps in the sample index are handled, call before Start()
+	void SetGapFill(SampleGapFill fill, SampleGapDelegateFn gapDel);
+	SampleGapFill GetGapFill() { return GapFill; }
+	
+	//  number of times the board was reconnected after the data stopped,
+	//  and the time from the last sample before the last reconnect to the first sample after it
+	int GetReconnects() { return Reconnects; }
+	double GetLastReconnectSeconds() { return LastReconnectSeconds; }
 		
 protected:
 	
@@ -91,12 +164,43 @@ protected:
 	
 	int NumberOfSamplesCounted;
 	ChronoTimer InspectDataStreamLogTimer;
-	void InspectDataStream(BFSample* data);
-	std::list<BFSample*> DataInspecting;
+	void InspectDataStream(const SampleBlock* data);
+	
+	//  gap detection from the sample index, and filling
+	SampleGapFill GapFill;
+	SampleGapDelegateFn SampleGapDelegate;
+	double GapLastIndex;
+	double GapLastTimeStamp;
+	std::vector<double> GapLastSample;
+	std::vector<SampleGap> Gaps;
+	int GapCount;
+	int GapLostSamples;
+	//
+	int GapIndexStep();
+	void ResetGapDetection();
+	SampleBlock* DetectGaps(SampleBlock* block);
+	SampleBlock* FillGaps(SampleBlock* block, int lostSamples);
+	void ReportGaps(const SampleBlock* block);
+	
+	//  reconnect time metric
+	int Reconnects;
+	double LastReconnectSeconds;
+	bool Reconnecting;
+	int ReconnectLostMilliseconds;
+	ChronoTimer ReconnectTimer;
+	//
+	void ReconnectStarted(int millisecondsWithoutData);
+	void ReconnectFinished();
+	
+	//  sample block storage, configured when the board layout is known
+	SampleBlockPool BlockPool;
+	void ConfigureBlockPool();
 	
 	void ConnectionChanged(BoardConnectionStates state, int boardId, int sampleRate);
+	void NewSample(const SampleBlock* block);
 	
 	NewSampleCallbackFn NewSampleCallback;
+	NewSampleDelegateFn NewSampleDelegate;
 	ConnectionChangedCallbackFn ConnectionChangedCallback;
 	ConnectionChangedDelegateFn ConnectionChangedDelegate;
 };
\ No newline at end of file
@@ -6,17 +6,55 @@
 #include <sys/time.h>
 #include <math.h>
 #include <chrono>
+#include <thread>
 #include <brainflow_constants.h>
 #include "brainHat.h"
 #include "BoardFileSimulator.h"
+#include "OpenBCIFileReader.h"
+#include "BDFFileReader.h"
 #include "StringExtensions.h"
-#include "BFSampleImplementation.h"
 #include "BoardIds.h"
 
 
 using namespace std;
 using namespace chrono;
 
+
+//  Playback mode names
+//
+string FilePlaybackModeName(FilePlaybackMode mode)
+{
+	switch (mode)
+	{
+	case PlaybackRealTime:
+		return "realtime";
+	case PlaybackMaximum:
+		return "max";
+	case PlaybackVirtualClock:
+		return "virtual";
+	default:
+		return "unknown";
+	}
+}
+
+
+//  Parse a playback mode name
+//
+bool ParseFilePlaybackMode(string name, FilePlaybackMode& mode)
+{
+	for (int i = PlaybackRealTime; i <= PlaybackVirtualClock; i++)
+	{
+		if (name == FilePlaybackModeName((FilePlaybackMode)i))
+		{
+			mode = (FilePlaybackMode)i;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
 //  Board Demo File Reader, reads data from a demo file and simulates live board
 //  Construct with callback functions:
 //    -  ConnectionChanged will be called on first discovery of board parameters, then on connect / disconnect state
@@ -29,6 +67,14 @@ BoardFileSimulator::BoardFileSimulator(ConnectionChangedCallbackFn connectionCha
 	
 	IsConnected = true;
 	StreamRunning = true;
+	
+	FileReader = NULL;
+	ReadAhead = NULL;
+	ReadAheadPosition = 0;
+	
+	PlaybackMode = PlaybackRealTime;
+	PlaybackSpeed = 1.0;
+	PlaybackTickMs = FILESIMULATOR_TICKMS;
 }
 
 
@@ -37,6 +83,12 @@ BoardFileSimulator::BoardFileSimulator(ConnectionChangedCallbackFn connectionCha
 BoardFileSimulator::~BoardFileSimulator()
 {
 	Cancel();
+	
+	if (ReadAhead != NULL)
+		ReadAhead->Release();
+	
+	if (FileReader != NULL)
+		delete FileReader;
 }
 
 
@@ -44,16 +96,32 @@ BoardFileSimulator::~BoardFileSimulator()
 //
 string BoardFileSimulator::ReportSource()
 {
+	if (PlaybackMode == PlaybackRealTime && PlaybackSpeed != 1.0)
+		return format("Demo File board %d at %d Hz, playback x%g", BoardId, SampleRate, PlaybackSpeed);
+	else if (PlaybackMode != PlaybackRealTime)
+		return format("Demo File board %d at %d Hz, playback %s", BoardId, SampleRate, FilePlaybackModeName(PlaybackMode).c_str());
+	
 	return format("Demo File board %d at %d Hz", BoardId, SampleRate);
 }
 
 
+//  Set the playback mode and speed
+//  the speed and tick only apply to real time playback
+//
+void BoardFileSimulator::SetPlayback(FilePlaybackMode mode, double speed, int tickMs)
+{
+	PlaybackMode = mode;
+	PlaybackSpeed = speed > 0.0 ? speed : 1.0;
+	PlaybackTickMs = tickMs > 0 ? tickMs : FILESIMULATOR_TICKMS;
+}
+
+
 
 //  Thread Start
 //
 int BoardFileSimulator::Start(string fileName)
 {
-	if (LoadFile(fileName))
+	if (OpenFile(fileName))
 	{
 		Thread::Start();
 		return 0;
@@ -69,152 +137,172 @@ void BoardFileSimulator::Cancel()
 {
 	Thread::Cancel();
 	
-	for (auto it = DataRecords.begin(); it != DataRecords.end(); ++it)
-		delete *it;
+	if (FileReader != NULL)
+		FileReader->Close();
 }
 
 
 //  Thread Run Function
+//  in real time the samples are released against a monotonic clock from the start of playback,
+//  on each tick every sample that is due is published, so a late tick catches up instead of putting playback behind
 //
 void BoardFileSimulator::RunFunction()
 {
+	if (!ReadNextWindow())
+		return;
+	
 	//  we will broadcast the simulator data as if it started now
-	double realStartTime = (duration_cast< seconds >(system_clock::now().time_since_epoch())).count();
+	double playbackStartTime = GetUnixTimeSeconds();
+	auto monotonicStartTime = steady_clock::now();
+	auto nextTick = monotonicStartTime;
 	
-	//  cache the time properties of the original data file
-	double fileStartTime = DataRecords.front()->TimeStamp;
-	double fileDuration = DataRecords.back()->TimeStamp - fileStartTime;
+	//  time of the first sample in the file
+	double fileStartTime = ReadAhead->TimeStamp(0);
 	double previousTimeStamp = fileStartTime;
 	
-	//  we will keep looping until we run out of double
-	double loopCounter = 0.0;
+	//  file time played in the previous passes through the file, so the clock carries on when the file starts again
+	double passOffset = 0.0;
 	
 	while (ThreadRunning)
 	{
-		for (auto it = DataRecords.begin(); it != DataRecords.end(); ++it)
+		//  at the end of the file, start again from the first sample
+		if (ReadAheadPosition >= ReadAhead->GetNumberOfSamples() && !ReadNextWindow())
 		{
-			if (!ThreadRunning)
+			if (!FileReader->Rewind() || !ReadNextWindow())
 				break;
 			
-			//  make new BCI data from the original
-			BFSample* nextSample = (*it)->Copy();
-			
-			//  set the demo time = start time of simulator + delta time in test + number of times looped * duration
-			nextSample->TimeStamp = realStartTime + ((*it)->TimeStamp - fileStartTime);
-			LastTimeStampSync = nextSample->TimeStamp;
-			
-			InspectDataStream(nextSample);
-			
-			//  broadcast the data
-			NewSampleCallback(nextSample);
-
-			
-			//  calculate the delay to wait for next epoch
-			usleep(((*it)->TimeStamp - previousTimeStamp) * 1000000.0);
-			previousTimeStamp = (*it)->TimeStamp;
-			
-			if(LastLoggedStatusTime.ElapsedMilliseconds() > 5000)
+			passOffset += (previousTimeStamp - fileStartTime) + 1.0 / SampleRate;
+			previousTimeStamp = fileStartTime;
+		}
+		
+		//  in real time the samples due by now, otherwise as much of the window as fits in a block
+		int count;
+		if (PlaybackMode == PlaybackRealTime)
+		{
+			double playedTime = duration<double>(steady_clock::now() - monotonicStartTime).count() * PlaybackSpeed;
+			count = SamplesDue(playedTime, passOffset, fileStartTime);
+			if (count == 0)
 			{
-				Logging.AddLog("BoardFileSimulator", "RunFunction", format("Reading raw data from %s. File time %.3lf.", FileName.c_str(), ((*it)->TimeStamp - fileStartTime)), LogLevelTrace);
-				LastLoggedStatusTime.Reset();
+				//  wait for the next tick, ticks stay on the grid from the start time
+				auto now = steady_clock::now();
+				while (nextTick <= now)
+					nextTick += milliseconds(PlaybackTickMs);
+				this_thread::sleep_until(nextTick);
+				continue;
 			}
 		}
+		else
+		{
+			count = ReadAhead->GetNumberOfSamples() - ReadAheadPosition;
+			if (count > BlockPool.GetBlockCapacity())
+				count = BlockPool.GetBlockCapacity();
+		}
 		
-		realStartTime = (duration_cast< seconds >(system_clock::now().time_since_epoch())).count();
-		previousTimeStamp = realStartTime;
-	}
-}
-
-
-
-// Load OpenBCI format txt file into the demo data collecion
-//
-bool BoardFileSimulator::LoadFile(std::string fileName)
-{
-	FileName = fileName;
-	
-	ifstream dataFile;
-	dataFile.open(fileName);
-
-	if (dataFile.is_open())
-	{	
-		string readLine;
-		while (!dataFile.eof())
+		//  make new BCI data from the original
+		SampleBlock* nextBlock = BlockPool.Get(count);
+		nextBlock->AppendSamples(ReadAhead, ReadAheadPosition, count);
+		ReadAheadPosition += count;
+		
+		double fileTimeStamp = nextBlock->TimeStamp(count - 1);
+		
+		//  set the demo time from the start time of the simulator and the delta time in the file
+		double* timeStamps = nextBlock->TimeStampRow();
+		double publishTime = GetUnixTimeSeconds();
+		for (int i = 0; i < count; i++)
 		{
-			getline(dataFile, readLine);
-			if (readLine.size() != 0)
+			switch (PlaybackMode)
 			{
-				if (readLine.substr(0, 1) == "%" || readLine.substr(0, 1) == "S")
-					ReadHeaderLine(readLine);
-				else
-					AddSample(readLine);
+			case PlaybackRealTime:
+				timeStamps[i] = playbackStartTime + (passOffset + timeStamps[i] - fileStartTime) / PlaybackSpeed;
+				break;
+			case PlaybackMaximum:
+				timeStamps[i] = publishTime;
+				break;
+			case PlaybackVirtualClock:
+				timeStamps[i] = playbackStartTime + passOffset + (timeStamps[i] - fileStartTime);
+				break;
 			}
 		}
-
-		dataFile.close();
+		LastTimeStampSync = timeStamps[count - 1];
+		
+		InspectDataStream(nextBlock);
+		
+		//  broadcast the data
+		NewSample(nextBlock);
+		nextBlock->Release();
+		
+		previousTimeStamp = fileTimeStamp;
 		
-		ConnectionChanged(New, BoardId, SampleRate);
-		return true;
+		if(LastLoggedStatusTime.ElapsedMilliseconds() > 5000)
+		{
+			Logging.AddLog("BoardFileSimulator", "RunFunction", format("Reading raw data from %s. File time %.3lf.", FileName.c_str(), (fileTimeStamp - fileStartTime)), LogLevelTrace);
+			LastLoggedStatusTime.Reset();
+		}
 	}
-	return false;
 }
 
 
-//  Add a sample from data file text line
+//  Count the samples in the read ahead window that are due to be published
+//  limited to one block from the pool
 //
-void BoardFileSimulator::AddSample(string readLine)
+int BoardFileSimulator::SamplesDue(double playedTime, double passOffset, double fileStartTime)
 {
-	auto newSample = new Sample(ExgChannelCount, AccelChannelCount, OtherChannelCount, AnalogChannelCount);
-	newSample->InitializeFromText(readLine);
-	DataRecords.push_back(newSample);
+	int available = ReadAhead->GetNumberOfSamples() - ReadAheadPosition;
+	if (available > BlockPool.GetBlockCapacity())
+		available = BlockPool.GetBlockCapacity();
 	
+	const double* fileTimeStamps = ReadAhead->TimeStampRow() + ReadAheadPosition;
+	int count = 0;
+	while (count < available && passOffset + (fileTimeStamps[count] - fileStartTime) <= playedTime)
+		count++;
+	
+	return count;
 }
 
 
-
-
-//  Read a header line to setup board parameters
+//  Read the next window of samples from the file
+//  returns false at the end of the file
 //
-void BoardFileSimulator::ReadHeaderLine(string readLine)
+bool BoardFileSimulator::ReadNextWindow()
 {
-	if (readLine.substr(0, 12) == "%Sample Rate")
-	{
-		auto rateString = readLine.substr(12);
-		Parser parseRate(rateString, " ");
-		auto discard = parseRate.GetNextString();
-		SampleRate = parseRate.GetNextInt();
-	}
-	else if (readLine.substr(0, 19) == "%Number of channels")
-	{
-		auto channelString = readLine.substr(19);
-		Parser parseRate(channelString, " ");
-		auto discard = parseRate.GetNextString();
-		int channels = parseRate.GetNextInt();
-		switch (channels)
-		{
-			
-		case 4:
-			BoardId = (int)BoardIds::GANGLION_BOARD;
-			break;
-			
-		case 8:
-			BoardId = (int)BoardIds::CYTON_BOARD;
-			break;
-			
-		case 16:
-			BoardId = (int)BoardIds::CYTON_DAISY_BOARD;
-			break;
-		default:
-			BoardId = (int)BrainhatBoardIds::UNDEFINED;
-			break;
-		}
-		
-		ExgChannelCount = getNumberOfExgChannels(BoardId);
-		AccelChannelCount = getNumberOfAccelChannels(BoardId);
-		OtherChannelCount = getNumberOfOtherChannels(BoardId);
-		AnalogChannelCount = getNumberOfAnalogChannels(BoardId);
-	}	
+	ReadAhead->SetNumberOfSamples(0);
+	ReadAheadPosition = 0;
+	
+	return FileReader->ReadSamples(ReadAhead, ReadAhead->GetCapacity()) > 0;
 }
 
 
-
+// Open an OpenBCI format txt file, and read the board parameters from the header
+//
+bool BoardFileSimulator::OpenFile(std::string fileName)
+{
+	FileName = fileName;
+	
+	//  the file format from the extension
+	if (FileReader != NULL)
+		delete FileReader;
+	string extension = fileName.size() > 4 ? fileName.substr(fileName.size() - 4) : "";
+	toUpper(extension);
+	if (extension == ".BDF")
+		FileReader = new BDFFileReader();
+	else
+		FileReader = new OpenBCIFileReader();
+	
+	if (!FileReader->Open(fileName))
+		return false;
+	
+	BoardId = FileReader->GetBoardId();
+	SampleRate = FileReader->GetSampleRate();
+	ExgChannelCount = FileReader->GetNumberOfExgChannels();
+	AccelChannelCount = FileReader->GetNumberOfAccelChannels();
+	OtherChannelCount = FileReader->GetNumberOfOtherChannels();
+	AnalogChannelCount = FileReader->GetNumberOfAnalogChannels();
+	
+	if (ReadAhead != NULL)
+		ReadAhead->Release();
+	ReadAhead = new SampleBlock(ExgChannelCount, AccelChannelCount, OtherChannelCount, AnalogChannelCount, SampleRate);
+	
+	ConfigureBlockPool();
+	ConnectionChanged(New, BoardId, SampleRate);
+	return true;
+}
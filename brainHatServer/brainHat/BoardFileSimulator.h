@@ -9,11 +9,29 @@
 #include "board_shim.h"
 #include "TimeExtensions.h"
 #include "BoardDataSource.h"
-#include "BFSample.h"
+#include "SampleFileReader.h"
+
+
+//  default real time playback tick, samples due in each tick are published together
+#define FILESIMULATOR_TICKMS (4)
+
+
+//  How the file simulator plays back the file
+//
+typedef enum
+{
+	PlaybackRealTime,		//  samples are published at the file sample times divided by the playback speed, time stamps from the wall clock
+	PlaybackMaximum,		//  samples are published as fast as the sample bus takes them, time stamps from the wall clock when published
+	PlaybackVirtualClock,	//  samples are published as fast as the sample bus takes them, time stamps start now and advance by the file sample times
+} FilePlaybackMode;
+
+std::string FilePlaybackModeName(FilePlaybackMode mode);
+bool ParseFilePlaybackMode(std::string name, FilePlaybackMode& mode);
 
 
 //  File Simulator Thread
-//  Will play back an OpenBCI_GUI format .txt file (adjusting time stamps so the data appears current)
+//  Will play back an OpenBCI_GUI format .txt file or a brainHat .bdf recording (adjusting time stamps so the data appears current)
+//  the file is read a window of samples ahead of playback, so playback starts at once and memory use does not grow with the file
 //
 class BoardFileSimulator : public BoardDataSource
 {
@@ -28,25 +46,27 @@ public:
 	
 	virtual void RunFunction();
 	
-	bool LoadFile(std::string fileName);
+	bool OpenFile(std::string fileName);
+	
+	//  set the playback mode, speed and real time tick before starting
+	void SetPlayback(FilePlaybackMode mode, double speed, int tickMs);
 	
 protected :
 	
 	virtual std::string ReportSource();
-		
-	void ReadHeaderLine(std::string readLine);
-	void AddSample(std::string readLine);
-	BFSample* CopySample(BFSample* sample);
-	
 	
+	std::string FileName;
+	SampleFileReader* FileReader;
 	
-	double StartTime;
-	double EndTime;
+	FilePlaybackMode PlaybackMode;
+	double PlaybackSpeed;
+	int PlaybackTickMs;
+	int SamplesDue(double playedTime, double passOffset, double fileStartTime);
 	
-	std::string FileName;
+	//  samples read ahead of playback
+	SampleBlock* ReadAhead;
+	int ReadAheadPosition;
+	bool ReadNextWindow();
 	
 	ChronoTimer LastLoggedStatusTime;
-	
-	std::list<BFSample*> DataRecords;
-
 };
\ No newline at end of file
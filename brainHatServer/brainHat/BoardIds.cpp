@@ -1,8 +1,12 @@
 #include <board_shim.h>
 #include "BoardIds.h"
+#include "SampleLayout.h"
 
 using namespace std;
 
+//  Contec frame rate
+#define CONTEC_SAMPLERATE (200)
+
 //   Number of EXG channels
 //
 int getNumberOfExgChannels(int boardId)
@@ -21,9 +25,11 @@ int getNumberOfExgChannels(int boardId)
 		return 0;
 		
 	case BrainhatBoardIds::CYTON_BOARD:
+		return CytonLayout::ExgChannels;
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
-		auto res = BoardShim::get_exg_channels(useBoardId);
-		return res.size();
+		return CytonDaisyLayout::ExgChannels;
+	case BrainhatBoardIds::CONTEC:
+		return ContecLayout::ExgChannels;
 	}
 }
 
@@ -45,9 +51,11 @@ int getNumberOfAccelChannels(int boardId)
 	default:
 		return 0;
 	case BrainhatBoardIds::CYTON_BOARD:
+		return CytonLayout::AccelChannels;
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
-		auto res = BoardShim::get_accel_channels(useBoardId);
-		return res.size();
+		return CytonDaisyLayout::AccelChannels;
+	case BrainhatBoardIds::CONTEC:
+		return ContecLayout::AccelChannels;
 	}
 }
 
@@ -69,9 +77,11 @@ int getNumberOfOtherChannels(int boardId)
 	default:
 		return 0;
 	case BrainhatBoardIds::CYTON_BOARD:
+		return CytonLayout::OtherChannels;
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
-		auto res = BoardShim::get_other_channels(useBoardId);
-		return res.size();
+		return CytonDaisyLayout::OtherChannels;
+	case BrainhatBoardIds::CONTEC:
+		return ContecLayout::OtherChannels;
 	}
 }
 
@@ -93,9 +103,11 @@ int getNumberOfAnalogChannels(int boardId)
 	default:
 		return 0;
 	case BrainhatBoardIds::CYTON_BOARD:
+		return CytonLayout::AnalogChannels;
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
-		auto res = BoardShim::get_analog_channels(useBoardId);
-		return res.size();
+		return CytonDaisyLayout::AnalogChannels;
+	case BrainhatBoardIds::CONTEC:
+		return ContecLayout::AnalogChannels;
 	}
 }
 
@@ -117,6 +129,8 @@ int getNumberOfRows(int boardId)
 	case BrainhatBoardIds::CYTON_BOARD:
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
 		return BoardShim::get_num_rows(useBoardId);
+	case BrainhatBoardIds::CONTEC:
+		return ContecLayout::Rows;
 	}
 }
 
@@ -138,6 +152,8 @@ int getSamplingRate(int boardId)
 	case BrainhatBoardIds::CYTON_BOARD:
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
 		return BoardShim::get_sampling_rate(useBoardId);
+	case BrainhatBoardIds::CONTEC:
+		return CONTEC_SAMPLERATE;
 	}
 }
 
@@ -172,6 +188,10 @@ string getSampleName(int boardId)
 		return "Ganglion_BFSample";
 	case BrainhatBoardIds::MENTALIUM:
 		return "MENTALIUM8";
+	case BrainhatBoardIds::CONTEC:
+		return "Contec20";
+	case BrainhatBoardIds::SIGNAL_GENERATOR:
+		return "SignalGenerator";
 	default:
 		return "BFSample";
 	}
@@ -192,6 +212,10 @@ string getSampleNameShort(int boardId)
 		return "GAN4";
 	case BrainhatBoardIds::MENTALIUM:
 		return "MT08";
+	case BrainhatBoardIds::CONTEC:
+		return "CT20";
+	case BrainhatBoardIds::SIGNAL_GENERATOR:
+		return "SGEN";
 	default:
 		return "BF";
 	}
@@ -213,6 +237,10 @@ string getEquipmentName(int boardId)
 		return "Ganglion";
 	case BrainhatBoardIds::MENTALIUM:
 		return "MENTALIUM";
+	case BrainhatBoardIds::CONTEC:
+		return "Contec";
+	case BrainhatBoardIds::SIGNAL_GENERATOR:
+		return "Signal Generator";
 	default:
 		return "";
 	}
@@ -227,6 +255,10 @@ string getManufacturerName(int boardId)
 	{
 	case BrainhatBoardIds::MENTALIUM:
 		return "Nelson";
+	case BrainhatBoardIds::CONTEC:
+		return "Contec";
+	case BrainhatBoardIds::SIGNAL_GENERATOR:
+		return "brainHat";
 	case BrainhatBoardIds::CYTON_BOARD:
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
 	case BrainhatBoardIds::GANGLION_BOARD:
@@ -11,6 +11,8 @@
 enum class BrainhatBoardIds : int
 {
 	UNDEFINED = -99,
+	SIGNAL_GENERATOR = -53,
+	CONTEC = -52,
 	MENTALIUM = -51,
 	CUSTOMBOARDS = -50,
 	//
@@ -0,0 +1,371 @@
+#include "brainHat.h"
+#include "BoardSession.h"
+#include "BoardDataReader.h"
+#include "CytonSerialReader.h"
+#include "ContecDataReader.h"
+#include "BoardFileSimulator.h"
+#include "OpenBCIFileWriter.h"
+#include "BDFFileWriter.h"
+#include "GpioControl.h"
+#include "StringExtensions.h"
+#include "Parser.h"
+
+using namespace std;
+
+
+//  Board Session
+//  Construct with the settings for the board, the primary session drives the status lights
+//
+BoardSession::BoardSession(BoardSessionSettings settings, bool primary) :
+	DataBroadcaster([this](bool connected) { OnLslConnectionStateChanged(connected); })
+{
+	Settings = settings;
+	Primary = primary;
+
+	DataSource = NULL;
+	FileWriter = NULL;
+}
+
+
+//  Destructor
+//
+BoardSession::~BoardSession()
+{
+	Stop();
+
+	if (DataSource != NULL)
+		delete DataSource;
+}
+
+
+//  Create the data source for the board, and start reading
+//
+int BoardSession::Start()
+{
+	DataBroadcaster.ConfigureQueue(Settings.LslQueueCapacity, Settings.LslQueuePolicy);
+	DataBroadcaster.SetValidityChannel(Settings.LiveData() && Settings.GapFill != GapFillNone);
+	DataBroadcaster.SetDevice(Settings.Device);
+	DataBroadcaster.SetMaxChunkDuration(Settings.LslChunkMs);
+	DataBroadcaster.SetEncoding(Settings.LslFormat, Settings.LslTimeStampChannel);
+	DerivedBroadcaster.SetStreams(Settings.Derived);
+	DerivedBroadcaster.SetDevice(Settings.Device);
+
+	if (Settings.LiveData() && Settings.BoardId == (int)BrainhatBoardIds::SIGNAL_GENERATOR)
+	{
+		auto generator = new SignalGenerator(NULL, NULL);
+		generator->SetSignal(Settings.Generator);
+		DataSource = generator;
+	}
+	else if (Settings.LiveData() && Settings.BoardId == (int)BrainhatBoardIds::CONTEC)
+	{
+		auto reader = new ContecDataReader(NULL, NULL);
+		reader->SetGapFill(Settings.GapFill, [this](const SampleGap& gap) { OnSampleGap(gap); });
+		DataSource = reader;
+	}
+	else if (Settings.LiveData() && Settings.NativeSerial)
+	{
+		auto reader = new CytonSerialReader(NULL, NULL);
+		reader->SetGapFill(Settings.GapFill, [this](const SampleGap& gap) { OnSampleGap(gap); });
+		DataSource = reader;
+	}
+	else if (Settings.LiveData())
+	{
+		auto reader = new BoardDataReader(NULL, NULL);
+		reader->SetReadMode(Settings.ReadMode, Settings.ReadMinBatch);
+		reader->SetGapFill(Settings.GapFill, [this](const SampleGap& gap) { OnSampleGap(gap); });
+		DataSource = reader;
+	}
+	else
+	{
+		auto simulator = new BoardFileSimulator(NULL, NULL);
+		simulator->SetPlayback(Settings.Playback, Settings.PlaybackSpeed, Settings.PlaybackTickMs);
+		DataSource = simulator;
+	}
+
+	DataSource->RegisterConnectionChangedDelegate([this](BoardConnectionStates state, int boardId, int sampleRate) { OnConnectionStateChanged(state, boardId, sampleRate); });
+	DataSource->RegisterNewSampleDelegate([this](const SampleBlock* block) { DataBus.Publish(block); });
+
+	if (Settings.LiveData())
+	{
+		Logging.AddLog("BoardSession", "Start", format("Starting board %d on %s%s.%s", Settings.BoardId, Settings.InputParams.serial_port.c_str(), Settings.NativeSerial ? " with the serial reader" : "", Settings.Device.size() > 0 ? format(" Device %s.", Settings.Device.c_str()).c_str() : ""), LogLevelInfo);
+		return DataSource->Start(Settings.BoardId, Settings.InputParams, Settings.StartSrbOn);
+	}
+	else
+	{
+		return ((BoardFileSimulator*)DataSource)->Start(Settings.DemoFileName);
+	}
+}
+
+
+//  Stop recording, stop all the threads, and release the blocks still queued
+//
+void BoardSession::Stop()
+{
+	StopRecording();
+
+	if (DataSource != NULL)
+		DataSource->Cancel();
+
+	DataBus.Unsubscribe(&DataBroadcaster);
+	DataBroadcaster.Cancel();
+	DataBus.Unsubscribe(&DerivedBroadcaster);
+	DerivedBroadcaster.Cancel();
+	StatusBroadcaster.Cancel();
+
+	//  the queued blocks belong to the data source block pool, release them while it still exists
+	DataBroadcaster.ClearQueue();
+	DerivedBroadcaster.ClearQueue();
+}
+
+
+//  Is the session recording
+//
+bool BoardSession::IsRecording()
+{
+	LockMutex lockFileWriter(FileWriterMutex);
+	return FileWriter != NULL && FileWriter->IsRecording();
+}
+
+
+//  Stop and delete the file writer
+//
+void BoardSession::StopRecording()
+{
+	LockMutex lockFileWriter(FileWriterMutex);
+
+	if (FileWriter != NULL)
+	{
+		DataBus.Unsubscribe(FileWriter);
+		FileWriter->Cancel();
+		delete FileWriter;
+		FileWriter = NULL;
+	}
+}
+
+
+//  Handle request to start/stop recording
+//
+bool BoardSession::HandleRecordingRequest(UriArgParser& requestParser, bool recordToUsb)
+{
+	if (DataSource == NULL)
+		return false;
+
+	auto fileName = requestParser.GetArg("filename");
+	auto enable = requestParser.GetArg("enable");
+
+	if (enable == "true")
+	{
+		StopRecording();
+
+		auto formatType = requestParser.GetArg("format");
+
+		FileHeaderInfo info;
+		info.SubjectName = requestParser.GetArg("name");
+		info.SubjectCode = requestParser.GetArg("code");
+		info.SubjectBirthday = requestParser.GetArg("birthday");
+		info.SubjectAdditional = requestParser.GetArg("additional");
+		info.SubjectGender = requestParser.GetArg("gender");
+		info.AdminCode = requestParser.GetArg("admin");
+		info.Technician = requestParser.GetArg("tech");
+		info.Device = Settings.Device;
+
+		LockMutex lockFileWriter(FileWriterMutex);
+
+		if (formatType.compare("txt") == 0)
+			FileWriter = new OpenBCIFileWriter([this](bool recording) { OnRecordingStateChanged(recording); });
+		else
+			FileWriter = new BDFFileWriter([this](bool recording) { OnRecordingStateChanged(recording); });
+
+		FileWriter->ConfigureQueue(Settings.RecordingQueueCapacity, Settings.RecordingQueuePolicy);
+		FileWriter->SetValidityChannel(DataSource->GetGapFill() != GapFillNone);
+		if (!FileWriter->StartRecording(fileName, recordToUsb, DataSource->GetBoardId(), DataSource->GetSampleRate(), info))
+		{
+			delete FileWriter;
+			FileWriter = NULL;
+			return false;
+		}
+		DataBus.Subscribe(FileWriter);
+	}
+	else if (enable == "false")
+	{
+		StopRecording();
+	}
+
+	return true;
+}
+
+
+//  Handle request to set SRB1
+//
+bool BoardSession::HandleSrbSetRequest(UriArgParser& requestParser)
+{
+	auto enable = requestParser.GetArg("enable");
+	toUpper(enable);
+	int board = ParseInt(requestParser.GetArg("board"));
+	if (enable == "TRUE" && board > -1)
+	{
+		DataSource->RequestSetSrb1(board, true);
+	}
+	else if (enable == "FALSE" && board > -1)
+	{
+		DataSource->RequestSetSrb1(board, false);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+//  Handle request to start / stop stream
+//
+bool BoardSession::HandleSetStreamRequest(UriArgParser& requestParser)
+{
+	auto enable = requestParser.GetArg("enable");
+	toUpper(enable);
+	if (enable == "TRUE")
+	{
+		DataSource->RequestEnableStreaming(true);
+	}
+	else if (enable == "FALSE")
+	{
+		DataSource->RequestEnableStreaming(false);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+//  Handle request to apply channel settings commands, a comma separated list of x...X commands
+//
+bool BoardSession::HandleChannelSetRequest(UriArgParser& requestParser)
+{
+	vector<string> commands;
+	Tokenize(requestParser.GetArg("commands"), commands, ",");
+	if (commands.size() == 0)
+		return false;
+	
+	return DataSource->RequestBoardCommands(commands);
+}
+
+
+//  Fill in the board, recording and queue status
+//
+void BoardSession::GetStatus(BrainHatServerStatus& status)
+{
+	status.Device = Settings.Device;
+
+	{
+		LockMutex lockFileWriter(FileWriterMutex);
+
+		bool recording = FileWriter != NULL && FileWriter->IsRecording();
+		status.RecordingDataBrainHat = recording;
+		status.RecordingFileNameBrainHat = recording ? FileWriter->FileName() : "";
+		status.RecordingDurationBrainHat = recording ? FileWriter->ElapsedRecordingTime() : 0.0;
+	}
+
+	status.SampleQueues = DataBus.GetStatus();
+
+	if (DataSource != NULL)
+	{
+		status.CytonSRB1 = DataSource->GetSrb1(0);
+		status.DaisySRB1 = DataSource->GetSrb1(1);
+		status.IsStreaming = DataSource->GetIsStreamRunning();
+		status.Reconnects = DataSource->GetReconnects();
+		status.LastReconnectSeconds = DataSource->GetLastReconnectSeconds();
+	}
+}
+
+
+//  Handle callback from data source when board connection state changed
+//  this will set the status lights for any board transition
+//  and for new board discovery, start the broadcasters now that the sample rate is known
+//
+void BoardSession::OnConnectionStateChanged(BoardConnectionStates state, int boardId, int sampleRate)
+{
+	if (state == New)
+	{
+		DataBroadcaster.SetBoard(boardId, sampleRate, DataSource->GetNumberOfExgChannels(), DataSource->GetNumberOfAccelChannels(), DataSource->GetNumberOfOtherChannels(), DataSource->GetNumberOfAnalogChannels());
+		DataBus.Subscribe(&DataBroadcaster);
+		if (Settings.Derived.Enabled() && DerivedBroadcaster.SetBoard(boardId, sampleRate, DataSource->GetNumberOfExgChannels()))
+			DataBus.Subscribe(&DerivedBroadcaster);
+		StatusBroadcaster.StartBroadcast(this, boardId, sampleRate);
+	}
+
+	if (!Primary)
+		return;
+
+	switch (state)
+	{
+	case Connected:
+		ConnectionLightShowReady();
+		break;
+
+	case Disconnected:
+		ConnectionLightShowConnecting();
+		break;
+
+	case StreamOn:
+		if (DataBroadcaster.HasClients())
+			ConnectionLightShowConnected();
+		else
+			ConnectionLightShowReady();
+		break;
+
+	case StreamOff:
+		ConnectionLightShowPaused();
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+// Handle callback from LSL broadcaster regarding client connections
+//
+void BoardSession::OnLslConnectionStateChanged(bool connected)
+{
+	if (!Primary)
+		return;
+
+	if (connected)
+	{
+		ConnectionLightShowConnected();
+	}
+	else if (DataSource->GetIsStreamRunning())
+	{
+		ConnectionLightShowReady();
+	}
+	else if (DataSource->GetIsConnected())
+	{
+		ConnectionLightShowPaused();
+	}
+	else
+	{
+		ConnectionLightShowConnecting();
+	}
+}
+
+
+// Handle callback from file recorder on the state of the recording file
+//
+void BoardSession::OnRecordingStateChanged(bool recording)
+{
+	if (Primary)
+		RecordingLight(recording);
+}
+
+
+//  Handle a gap in the samples from the data source
+//
+void BoardSession::OnSampleGap(const SampleGap& gap)
+{
+	DataBroadcaster.BroadcastGap(gap);
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include "board_shim.h"
+#include "BoardIds.h"
+#include "BoardDataSource.h"
+#include "BoardDataReader.h"
+#include "BoardFileSimulator.h"
+#include "SignalGenerator.h"
+#include "BroadcastData.h"
+#include "BroadcastDerivedData.h"
+#include "BroadcastStatus.h"
+#include "BrainHatFileWriter.h"
+#include "BrainHatServerStatus.h"
+#include "SampleBus.h"
+#include "UriParser.h"
+
+
+//  Settings for one board, from the command line
+//
+struct BoardSessionSettings
+{
+public:
+
+	//  name used to select the board in requests, empty for a single board
+	std::string Device;
+
+	int BoardId;
+	struct BrainFlowInputParams InputParams;
+	std::string DemoFileName;
+	FilePlaybackMode Playback;
+	double PlaybackSpeed;
+	int PlaybackTickMs;
+	SignalGeneratorSettings Generator;
+	bool StartSrbOn;
+	//
+	//  read the Cyton serial port directly instead of through brainflow
+	bool NativeSerial;
+	BoardReadMode ReadMode;
+	int ReadMinBatch;
+	SampleGapFill GapFill;
+	//
+	int LslQueueCapacity;
+	int LslChunkMs;
+	LslEncoding LslFormat;
+	bool LslTimeStampChannel;
+	DerivedStreamSettings Derived;
+	SampleBusOverflowPolicy LslQueuePolicy;
+	int RecordingQueueCapacity;
+	SampleBusOverflowPolicy RecordingQueuePolicy;
+
+	BoardSessionSettings()
+	{
+		Device = "";
+		BoardId = (int)BrainhatBoardIds::CYTON_BOARD;
+		DemoFileName = "";
+		Playback = PlaybackRealTime;
+		PlaybackSpeed = 1.0;
+		PlaybackTickMs = FILESIMULATOR_TICKMS;
+		StartSrbOn = false;
+		NativeSerial = false;
+		ReadMode = ReadFixedInterval;
+		ReadMinBatch = 1;
+		GapFill = GapFillNone;
+		LslQueueCapacity = SAMPLEQUEUE_CAPACITY;
+		LslChunkMs = BROADCAST_CHUNKMS;
+		LslFormat = LslDouble64;
+		LslTimeStampChannel = true;
+		LslQueuePolicy = OverflowDropOldest;
+		RecordingQueueCapacity = SAMPLEQUEUE_CAPACITY;
+		RecordingQueuePolicy = OverflowDropNewest;
+	}
+
+	bool LiveData() { return BoardId != (int)BrainhatBoardIds::UNDEFINED; }
+};
+
+
+//  Board Session
+//  One board (or demo file) and everything that serves its data:
+//  the data source, the sample bus, the LSL data, derived data and status outlets, and the file recorder
+//
+//  the logger, command server and status lights are shared by all the sessions in the process,
+//  the status lights show the state of the primary session
+//
+class BoardSession
+{
+public:
+	BoardSession(BoardSessionSettings settings, bool primary);
+	virtual ~BoardSession();
+
+	//  start reading the board, returns 0 on success
+	int Start();
+
+	//  stop recording, stop all the threads, and release the blocks still queued
+	void Stop();
+
+	std::string GetDevice() { return Settings.Device; }
+	BoardDataSource* GetDataSource() { return DataSource; }
+	bool IsRecording();
+
+	//  requests from the command server
+	bool HandleRecordingRequest(UriArgParser& requestParser, bool recordToUsb);
+	bool HandleSrbSetRequest(UriArgParser& requestParser);
+	bool HandleSetStreamRequest(UriArgParser& requestParser);
+	bool HandleChannelSetRequest(UriArgParser& requestParser);
+
+	//  board, recording and queue status
+	void GetStatus(BrainHatServerStatus& status);
+
+protected:
+
+	BoardSessionSettings Settings;
+	bool Primary;
+
+	BoardDataSource* DataSource;
+	SampleBus DataBus;
+	BroadcastData DataBroadcaster;
+	BroadcastDerivedData DerivedBroadcaster;
+	BroadcastStatus StatusBroadcaster;
+
+	std::mutex FileWriterMutex;
+	BrainHatFileWriter* FileWriter;
+	void StopRecording();
+
+	//  component events
+	void OnConnectionStateChanged(BoardConnectionStates state, int boardId, int sampleRate);
+	void OnLslConnectionStateChanged(bool connected);
+	void OnRecordingStateChanged(bool recording);
+	void OnSampleGap(const SampleGap& gap);
+};
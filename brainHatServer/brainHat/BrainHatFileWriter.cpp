@@ -11,15 +11,15 @@
 
 using namespace std;
 
-BrainHatFileWriter::BrainHatFileWriter(RecordingStateChangedCallbackFn fn)
+BrainHatFileWriter::BrainHatFileWriter(RecordingStateChangedCallbackFn fn) : SampleBusSubscriber("BrainHatFileWriter", SAMPLEQUEUE_CAPACITY, SAMPLEQUEUE_BATCH, OverflowBlock)
 {
 	Recording = false;
+	ValidityChannel = false;
 	RecordingStateChangedCallback = fn;
 }
 
 BrainHatFileWriter::~BrainHatFileWriter()
 {
-	
 }
 
 
@@ -29,6 +29,13 @@ bool BrainHatFileWriter::StartRecording(string fileName, bool tryUsb, int boardI
 {	
 	HeaderInfo = info;
 	
+	//  the board has not connected yet
+	if (sampleRate <= 0)
+	{
+		Logging.AddLog("BrainHatFileWriter", "StartRecording", format("Unable to record board %d before its sample rate is known.", boardId), LogLevelError);
+		return false;
+	}
+	
 	if (OpenFile(fileName, tryUsb))
 	{
 		BoardId = boardId;
@@ -158,17 +165,11 @@ bool CheckRecordingFolder(string fileName, bool tryUsb, std::string& pathToRecFo
 
 
 
-//  Add data to the queue
+//  Data was queued by the sample bus, wake up the thread
 //
-void BrainHatFileWriter::AddData(BFSample* data)
+void BrainHatFileWriter::DataQueued()
 {
-	if (!Recording)
-		return;
-	
-	{
-		LockMutex lockQueue(QueueMutex);
-		SamplesQueue.push(data);
-	}
+	RunSignal.Notify();
 }
 
 
@@ -176,10 +177,19 @@ void BrainHatFileWriter::AddData(BFSample* data)
 //
 void BrainHatFileWriter::RunFunction()
 {
+	QueueStatsTimer.Start();
+	
+	//  write data as soon as the sample bus signals it is in the queue
 	while (ThreadRunning)
 	{		
-		Sleep(10);
+		RunSignal.WaitFor(5000 - QueueStatsTimer.ElapsedMilliseconds());
 		WriteDataToFile();
+		
+		if (QueueStatsTimer.ElapsedMilliseconds() >= 5000)
+		{
+			LogQueueStatistics(GetWakeups(), QueueStatsTimer.ElapsedSeconds());
+			QueueStatsTimer.Reset();
+		}
 	}
 }
 
@@ -192,7 +202,10 @@ void BrainHatFileWriter::SetFilePath(string pathToRecFolder, string sessionName,
 
 	//  create file name from test name and start time
 	ostringstream os;		
-	os << sessionName << "_" << setw(4) << timeNow->tm_year + 1900 << setfill('0') << setw(2) << timeNow->tm_mon + 1 << setfill('0') << setw(2) << timeNow->tm_mday << "-" << setfill('0') << setw(2) << timeNow->tm_hour << setfill('0') << setw(2) << timeNow->tm_min  << setfill('0') << setw(2) << timeNow->tm_sec << "." << extension;	
+	os << sessionName << "_";
+	if (HeaderInfo.Device.size() > 0)
+		os << HeaderInfo.Device << "_";
+	os << setw(4) << timeNow->tm_year + 1900 << setfill('0') << setw(2) << timeNow->tm_mon + 1 << setfill('0') << setw(2) << timeNow->tm_mday << "-" << setfill('0') << setw(2) << timeNow->tm_hour << setfill('0') << setw(2) << timeNow->tm_min  << setfill('0') << setw(2) << timeNow->tm_sec << "." << extension;	
 	RecordingFileName = os.str();	
 	os.str("");
 	os << pathToRecFolder << RecordingFileName;	
@@ -1,9 +1,10 @@
 #pragma once
 #include <string>
-#include <queue>
+#include <functional>
 #include <condition_variable>
 #include "Thread.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
+#include "SampleBus.h"
 #include "TimeExtensions.h"
 
 #define RECORDINGFOLDER ("/home/pi/EEG")
@@ -58,9 +59,9 @@ public:
 
 bool CheckRecordingFolder(std::string sessionName, bool tryUsb, std::string& pathToRecFolder);
 
-typedef void(*RecordingStateChangedCallbackFn)(bool);
+typedef std::function<void(bool)> RecordingStateChangedCallbackFn;
 
-class BrainHatFileWriter : public Thread
+class BrainHatFileWriter : public Thread, public SampleBusSubscriber
 {
 	
 public:
@@ -72,8 +73,9 @@ public:
 	virtual void Cancel();
 	virtual void RunFunction();
 	
-		
-	void AddData(BFSample* data);
+	
+	//  record the sample validity flag, for boards with gap filling, call before StartRecording()
+	void SetValidityChannel(bool enable) { ValidityChannel = enable; }
 	
 	bool IsRecording() {return Recording;}
 	double ElapsedRecordingTime() {return ElapsedTime.ElapsedSeconds();}
@@ -95,14 +97,16 @@ protected:
 	virtual void CloseFile() = 0;
 	
 	bool WroteHeader;
+	bool ValidityChannel;
 
 	
 	bool Recording;
 	std::mutex RecordingFileMutex;
 	
-	//  queue lock
-	std::mutex QueueMutex;
-	std::queue<BFSample*> SamplesQueue;
+	//  sample bus
+	virtual bool AcceptsData() { return Recording; }
+	virtual void DataQueued();
+	ChronoTimer QueueStatsTimer;
 	
 	ChronoTimer ElapsedTime;
 	
@@ -1,13 +1,16 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "json.hpp"
 #include "BoardIds.h"
+#include "SampleBus.h"
 
 struct BrainHatServerStatus
 {
 public:
 	
 	std::string HostName;
+	std::string Device;
 	std::string Eth0Address;
 	std::string Wlan0Address;
 	std::string Wlan0Mode;
@@ -17,6 +20,8 @@ public:
 	int CytonSRB1;
 	int DaisySRB1;
 	bool IsStreaming;
+	int Reconnects;
+	double LastReconnectSeconds;
 	//
 	bool RecordingDataBrainHat;
 	bool RecordingDataBoard;
@@ -25,12 +30,18 @@ public:
 	double RecordingDurationBrainHat;
 	double RecordingDurationBoard;
 	//
+	std::vector<SampleBusSubscriberStatus> SampleQueues;
+	int LogQueueDepth;
+	int LogQueueMaxDepth;
+	unsigned long long LogsDropped;
+	//
 	long long UnixTimeMillis;
 	
 	
 	BrainHatServerStatus()
 	{
 		HostName = "";
+		Device = "";
 		Eth0Address = "";
 		Wlan0Address = "";
 		Wlan0Mode = "";
@@ -39,12 +50,17 @@ public:
 		CytonSRB1 = -1;
 		DaisySRB1 = -1;
 		IsStreaming = false;
+		Reconnects = 0;
+		LastReconnectSeconds = 0.0;
 		RecordingDataBrainHat = false;
 		RecordingDataBoard = false;
 		RecordingFileNameBrainHat = "";
 		RecordingFileNameBoard = "";
 		RecordingDurationBrainHat = 0.0;
 		RecordingDurationBoard = 0.0;
+		LogQueueDepth = 0;
+		LogQueueMaxDepth = 0;
+		LogsDropped = 0;
 		UnixTimeMillis = 0;
 	}
 	
@@ -54,6 +70,7 @@ public:
 		nlohmann::json j;
 		
 		j["HostName"] = HostName;
+		j["Device"] = Device;
 		j["Eth0Address"] = Eth0Address;
 		j["Wlan0Address"] = Wlan0Address;
 		j["Wlan0Mode"] = Wlan0Mode;
@@ -62,12 +79,23 @@ public:
 		j["CytonSRB1"] = CytonSRB1;
 		j["DaisySRB1"] = DaisySRB1;
 		j["IsStreaming"] = IsStreaming;
+		j["Reconnects"] = Reconnects;
+		j["LastReconnectSeconds"] = LastReconnectSeconds;
 		j["RecordingDataBrainHat"] = RecordingDataBrainHat;
 		j["RecordingDataBoard"] = RecordingDataBoard;
 		j["RecordingFileNameBrainHat"] = RecordingFileNameBrainHat;
 		j["RecordingFileNameBoard"] = RecordingFileNameBoard;
 		j["RecordingDurationBrainHat"] = RecordingDurationBrainHat;
 		j["RecordingDurationBoard"] = RecordingDurationBoard;
+		
+		nlohmann::json queues = nlohmann::json::array();
+		for (auto it = SampleQueues.begin(); it != SampleQueues.end(); ++it)
+			queues.push_back(it->AsJson());
+		j["SampleQueues"] = queues;
+		j["LogQueueDepth"] = LogQueueDepth;
+		j["LogQueueMaxDepth"] = LogQueueMaxDepth;
+		j["LogsDropped"] = LogsDropped;
+		
 		j["UnixTimeMillis"] = UnixTimeMillis;
 		
 		return j;
@@ -1,6 +1,9 @@
 #include <list>
+#include <string.h>
 #include <unistd.h>
 #include <iostream>
+#include <cmath>
+#include <stdint.h>
 #include <lsl_cpp.h>
 
 #include "brainHat.h"
@@ -10,7 +13,8 @@
 #include "wiringPi.h"
 #include "json.hpp"
 #include "NetworkAddresses.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
+#include "SampleLayout.h"
 #include "BrainHatServerStatus.h"
 #include "NetworkExtensions.h"
 #include "BoardIds.h"
@@ -24,16 +28,79 @@ using namespace lsl;
 
 
 
+//  Encoding names
+//
+string LslEncodingName(LslEncoding encoding)
+{
+	switch (encoding)
+	{
+	case LslDouble64:
+		return "double";
+	case LslFloat32:
+		return "float32";
+	case LslInt32:
+		return "int32";
+	default:
+		return "unknown";
+	}
+}
+
+
+//  Parse an encoding name
+//
+bool ParseLslEncoding(string name, LslEncoding& encoding)
+{
+	for (int i = LslDouble64; i <= LslInt32; i++)
+	{
+		if (name == LslEncodingName((LslEncoding)i))
+		{
+			encoding = (LslEncoding)i;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+//  Encode one value
+//
+inline void EncodeValue(double value, double& encoded) { encoded = value; }
+inline void EncodeValue(double value, float& encoded) { encoded = (float)value; }
+inline void EncodeValue(double value, int32_t& encoded)
+{
+	//  NaN (samples filled in for a gap) is sent as the minimum value
+	if (std::isnan(value) || value <= -2147483647.0)
+		encoded = INT32_MIN;
+	else if (value >= 2147483647.0)
+		encoded = INT32_MAX;
+	else
+		encoded = (int32_t)lround(value);
+}
+
+
 //  Broadcast data thread
 //  Sends samples to the network using LSL
 //
-BroadcastData::BroadcastData(ClientConnectionChangedCallbackFn fn)
+BroadcastData::BroadcastData(ClientConnectionChangedCallbackFn fn) : SampleBusSubscriber("BroadcastData", SAMPLEQUEUE_CAPACITY, SAMPLEQUEUE_BATCH, OverflowDropOldest)
 {
 	ClientConnectionChangedCallback = fn;
 	ClientsConnected = false;
 	
 	LslEnabled = true;
 	LSLOutlet = NULL;
+	GapOutlet = NULL;
+	ValidityChannel = false;
+	ExgChannels = 0;
+	AccelChannels = 0;
+	OtherChannels = 0;
+	AnalogChannels = 0;
+	BlockFunctions = NULL;
+	Encoding = LslDouble64;
+	TimeStampChannel = true;
+	MaxChunkMilliseconds = BROADCAST_CHUNKMS;
+	MaxChunkSamples = 1;
+	ChunkCount = 0;
 }
 
 
@@ -43,15 +110,21 @@ BroadcastData::~BroadcastData()
 {
 	if(LSLOutlet != NULL)
 		delete LSLOutlet;
+	if (GapOutlet != NULL)
+		delete GapOutlet;
 }
 
 
 //  Set Board properties, and kick off the broadcast thread
 //
-void BroadcastData::SetBoard(int boardId, int sampleRate)
+void BroadcastData::SetBoard(int boardId, int sampleRate, int exgChannels, int accelChannels, int otherChannels, int analogChannels)
 {
 	BoardId = boardId;
 	SampleRate = sampleRate;
+	ExgChannels = exgChannels;
+	AccelChannels = accelChannels;
+	OtherChannels = otherChannels;
+	AnalogChannels = analogChannels;
 	HostName = GetHostName();
 	
 	SetupLslForBoard();
@@ -65,76 +138,174 @@ void BroadcastData::SetBoard(int boardId, int sampleRate)
 //
 void BroadcastData::SetupLslForBoard()
 {
-	int numChannels = getNumberOfExgChannels(BoardId);
-	int accelChannels = getNumberOfAccelChannels(BoardId);
-	int otherChannels = getNumberOfOtherChannels(BoardId);
-	int analogChannels = getNumberOfAnalogChannels(BoardId);
+	int numChannels = ExgChannels;
+	int accelChannels = AccelChannels;
+	int otherChannels = OtherChannels;
+	int analogChannels = AnalogChannels;
+	
+	//  the compact encodings send the time stamp only as the LSL time stamp
+	if (Encoding != LslDouble64)
+		TimeStampChannel = false;
+	
+	//  calculate sample size, is number of data elements plus sample index plus time stamp if it is sent as a channel, plus the validity flag if enabled
+	BlockSampleSize = 2 + numChannels + accelChannels + otherChannels + analogChannels;
+	SampleSize = BlockSampleSize - (TimeStampChannel ? 0 : 1) + (ValidityChannel ? 1 : 0);
+	BlockFunctions = &GetSampleBlockFunctions(numChannels, accelChannels, otherChannels, analogChannels);
+	
+	//  counts per unit for each block value, the time stamp is never scaled
+	ChannelScale.assign(BlockSampleSize, 1.0);
+	if (Encoding == LslInt32)
+	{
+		int channel = 1;
+		for (int k = 0; k < numChannels; k++)
+			ChannelScale[channel++] = 1.0 / BROADCAST_INT32_EXGSCALE;
+		for (int k = 0; k < accelChannels; k++)
+			ChannelScale[channel++] = 1.0 / BROADCAST_INT32_ACCELSCALE;
+		for (int k = 0; k < otherChannels; k++)
+			ChannelScale[channel++] = 1.0 / BROADCAST_INT32_OTHERSCALE;
+		for (int k = 0; k < analogChannels; k++)
+			ChannelScale[channel++] = 1.0 / BROADCAST_INT32_ANALOGSCALE;
+	}
+	
+	//  chunk buffers, at least one sample
+	MaxChunkSamples = (SampleRate * MaxChunkMilliseconds) / 1000;
+	if (MaxChunkSamples < 1)
+		MaxChunkSamples = 1;
+	switch (Encoding)
+	{
+	case LslDouble64:
+		ChunkSamples.resize(MaxChunkSamples * SampleSize);
+		break;
+	case LslFloat32:
+		ChunkFloatSamples.resize(MaxChunkSamples * SampleSize);
+		break;
+	case LslInt32:
+		ChunkIntSamples.resize(MaxChunkSamples * SampleSize);
+		break;
+	}
+	ChunkTimeStamps.resize(MaxChunkSamples);
+	ChunkCount = 0;
+	
+	//  each board served by this host has its own source id
+	string sourceId = Device.size() > 0 ? format("%s-%s", HostName.c_str(), Device.c_str()) : HostName;
 	
-	//  calculate sample size, is number of data elements plus time stamp plus sample index
-	SampleSize = 2 + numChannels + accelChannels + otherChannels + analogChannels;
+	lsl::channel_format_t channelFormat = lsl::cf_double64;
+	if (Encoding == LslFloat32)
+		channelFormat = lsl::cf_float32;
+	else if (Encoding == LslInt32)
+		channelFormat = lsl::cf_int32;
 	
-	lsl::stream_info info(getSampleName(BoardId), "BFSample", SampleSize, SampleRate, lsl::cf_double64, HostName);
+	lsl::stream_info info(getSampleName(BoardId), "BFSample", SampleSize, SampleRate, channelFormat, sourceId);
 	
 	// add some description fields
 	info.desc().append_child_value("manufacturer", getManufacturerName(BoardId));
 	info.desc().append_child_value("boardId", format("%d", BoardId));
+	info.desc().append_child_value("device", Device);
+	info.desc().append_child_value("encoding", LslEncodingName(Encoding));
 	lsl::xml_element chns = info.desc().append_child("channels");
 	
-	chns.append_child("channel")
+	int channel = 0;
+	lsl::xml_element ch = chns.append_child("channel")
 		.append_child_value("label", "SampleIndex")
 		.append_child_value("unit", "0-255")
 		.append_child_value("type", "index");
+	AddChannelScale(ch, channel++);
 	
 	for (int k = 0; k < numChannels; k++)
-		chns.append_child("channel")
-		.append_child_value("label", format("ExgCh%d", k))
-		.append_child_value("unit", "uV")
-		.append_child_value("type", "EEG");
+	{
+		ch = chns.append_child("channel")
+			.append_child_value("label", format("ExgCh%d", k))
+			.append_child_value("unit", "uV")
+			.append_child_value("type", "EEG");
+		AddChannelScale(ch, channel++);
+	}
 	
 	for (int k = 0; k < accelChannels; k++)
-		chns.append_child("channel")
-		.append_child_value("label", format("AcelCh%d", k))
-		.append_child_value("unit", "1.0")
-		.append_child_value("type", "Accelerometer");
+	{
+		ch = chns.append_child("channel")
+			.append_child_value("label", format("AcelCh%d", k))
+			.append_child_value("unit", "1.0")
+			.append_child_value("type", "Accelerometer");
+		AddChannelScale(ch, channel++);
+	}
 	
 	for (int k = 0; k < otherChannels; k++)
-		chns.append_child("channel")
-		.append_child_value("label", format("Other%d", k));
+	{
+		ch = chns.append_child("channel")
+			.append_child_value("label", format("Other%d", k));
+		AddChannelScale(ch, channel++);
+	}
 	
 	for (int k = 0; k < analogChannels; k++)
-		chns.append_child("channel")
-		.append_child_value("label", format("AngCh%d", k));
+	{
+		ch = chns.append_child("channel")
+			.append_child_value("label", format("AngCh%d", k));
+		AddChannelScale(ch, channel++);
+	}
 	
-	chns.append_child("channel")
+	//  without the time stamp channel the time stamp is only the LSL time stamp of the sample
+	if (TimeStampChannel)
+		chns.append_child("channel")
 		.append_child_value("label", "TimeStamp")
 		.append_child_value("unit", "s");
+	
+	if (ValidityChannel)
+	{
+		ch = chns.append_child("channel")
+			.append_child_value("label", "Valid")
+			.append_child_value("unit", "0-1")
+			.append_child_value("type", "validity");
+		if (Encoding == LslInt32)
+			ch.append_child_value("scale", "1");
+	}
 
 	// make a new outlet
 	LSLOutlet = new lsl::stream_outlet(info);
+	
+	//  gap events, one json string per gap
+	lsl::stream_info gapInfo(getSampleName(BoardId) + "Gaps", "Markers", 1, lsl::IRREGULAR_RATE, lsl::cf_string, sourceId);
+	gapInfo.desc().append_child_value("boardId", format("%d", BoardId));
+	gapInfo.desc().append_child_value("device", Device);
+	GapOutlet = new lsl::stream_outlet(gapInfo);
 }
 
 
 
-//  Add data to the broadcast queue
+//  Add the value of one count to the channel description, for the int32 encoding
 //
-void BroadcastData::AddData(BFSample* data)
+void BroadcastData::AddChannelScale(lsl::xml_element& channel, int column)
 {
-	{
-		LockMutex lockQueue(QueueMutex);
-		SamplesQueue.push(data);
-	}
+	if (Encoding == LslInt32)
+		channel.append_child_value("scale", format("%g", 1.0 / ChannelScale[column]));
+}
+
+
+
+//  Data was queued by the sample bus, wake up the thread
+//
+void BroadcastData::DataQueued()
+{
+	RunSignal.Notify();
 }
 
 
 //  Run function
-//  sends out data from the queue
+//  sends out data from the queue, sleeps until the sample bus signals there is more
 //
 void BroadcastData::RunFunction()
 {
+	QueueStatsTimer.Start();
+	
 	while (ThreadRunning)
 	{		
-		Sleep(1);
+		RunSignal.WaitFor(5000 - QueueStatsTimer.ElapsedMilliseconds());
 		BroadcastDataToLslOutlet();
+		
+		if (QueueStatsTimer.ElapsedMilliseconds() >= 5000)
+		{
+			LogQueueStatistics(GetWakeups(), QueueStatsTimer.ElapsedSeconds());
+			QueueStatsTimer.Reset();
+		}
 	}
 }
 
@@ -144,52 +315,175 @@ void BroadcastData::RunFunction()
 //
 void BroadcastData::BroadcastDataToLslOutlet()
 {
-	int queueCount = SamplesQueue.size();
-	if (queueCount == 0)
-		return;
+	int queueCount = 0;
+	int count;
 	
-	double rawSample[SampleSize];
+	//  take the blocks from the queue a batch at a time
+	while ((count = TakeBatch()) > 0)
+	{
+		for (int i = 0; i < count; i++)
+			queueCount += Batch[i]->GetNumberOfSamples();
+		
+		BroadcastBatch(count);
+		
+		for (int i = 0; i < count; i++)
+			Batch[i]->Release();
+	}
 	
-	//  empty the queue and put the samples to send into a list
-	list<BFSample*> samples;
+	//  monitor performance, generate warning any time the queue is backed up more than one second
+	if(queueCount > SampleRate )
+	{
+		Logging.AddLog("BroadcastData", "BroadcastDataToLslOutlet", format("Broadcast is more than one second behind. Queue size %d", queueCount), LogLevelWarn);
+	}
+}
+
+
+//  Broadcast a batch of blocks to the LSL outlet
+//  the samples are pushed in chunks of up to the maximum chunk duration,
+//  each sample with its own time stamp moved from the wall clock to the LSL clock
+//
+void BroadcastData::BroadcastBatch(int count)
+{
+	if(LSLOutlet->have_consumers())
 	{
-		LockMutex lockQueue(QueueMutex);
+		double lslClockOffset = lsl::local_clock() - GetUnixTimeSeconds();
 		
-		while (SamplesQueue.size() > 0)
+		for (int b = 0; b < count; b++)
 		{
-			samples.push_back(SamplesQueue.front());
-			SamplesQueue.pop();
+			const SampleBlock* block = Batch[b];
+			int samples = block->GetNumberOfSamples();
+			int first = 0;
+			while (first < samples)
+			{
+				int add = samples - first;
+				if (add > MaxChunkSamples - ChunkCount)
+					add = MaxChunkSamples - ChunkCount;
+				
+				AddToChunk(block, first, add, lslClockOffset);
+				first += add;
+				
+				if (ChunkCount == MaxChunkSamples)
+					PushChunk();
+			}
+		}
+		
+		PushChunk();
+			
+		if (!ClientsConnected)
+		{
+			ClientsConnected = true;
+			ClientConnectionChangedCallback(true);
 		}
 	}
+	else if(ClientsConnected)
+	{
+		ClientsConnected = false;
+		ClientConnectionChangedCallback(false);
+	}
+}
+
+
+//  Add samples to the end of the chunk
+//
+void BroadcastData::AddToChunk(const SampleBlock* block, int first, int count, double lslClockOffset)
+{
+	if (Encoding == LslDouble64 && TimeStampChannel && !ValidityChannel)
+	{
+		//  the block samples are the stream samples
+		BlockFunctions->Multiplex(block, first, count, ChunkSamples.data() + (ChunkCount * SampleSize));
+	}
+	else
+	{
+		//  the block samples, then packed into the stream samples
+		if ((int)RawSamples.size() < count * BlockSampleSize)
+			RawSamples.resize(count * BlockSampleSize);
+		BlockFunctions->Multiplex(block, first, count, RawSamples.data());
+		
+		const unsigned char* validity = block->ValidityRow() + first;
+		switch (Encoding)
+		{
+		case LslDouble64:
+			PackSamples(RawSamples.data(), validity, count, ChunkSamples.data() + (ChunkCount * SampleSize));
+			break;
+		case LslFloat32:
+			PackSamples(RawSamples.data(), validity, count, ChunkFloatSamples.data() + (ChunkCount * SampleSize));
+			break;
+		case LslInt32:
+			PackSamples(RawSamples.data(), validity, count, ChunkIntSamples.data() + (ChunkCount * SampleSize));
+			break;
+		}
+	}
+	
+	const double* timeStamps = block->TimeStampRow() + first;
+	for (int i = 0; i < count; i++)
+		ChunkTimeStamps[ChunkCount + i] = timeStamps[i] + lslClockOffset;
 	
-	//  broadcast the data
-	for(auto nextSample = samples.begin() ; nextSample != samples.end() ; ++nextSample)
+	ChunkCount += count;
+}
+
+
+//  Pack multiplexed block samples into stream samples
+//  drops the time stamp (the last block value) if it is not sent as a channel, and adds the validity flag if enabled
+//
+template <typename T> void BroadcastData::PackSamples(const double* raw, const unsigned char* validity, int count, T* chunk)
+{
+	int values = TimeStampChannel ? BlockSampleSize : BlockSampleSize - 1;
+	const double* scale = ChannelScale.data();
+	
+	for (int i = 0; i < count; i++)
 	{
-		//  LSL broadcast
-		if(LSLOutlet->have_consumers())
+		const double* rawSample = raw + (i * BlockSampleSize);
+		T* sample = chunk + (i * SampleSize);
+		
+		if (Encoding == LslInt32)
 		{
-			(*nextSample)->AsRawSample(rawSample);
-			LSLOutlet->push_sample(rawSample);
-			
-			if (!ClientsConnected)
-			{
-				ClientsConnected = true;
-				ClientConnectionChangedCallback(true);
-			}
+			for (int j = 0; j < values; j++)
+				EncodeValue(rawSample[j] * scale[j], sample[j]);
 		}
-		else if(ClientsConnected)
+		else
 		{
-			ClientsConnected = false;
-			ClientConnectionChangedCallback(false);
+			for (int j = 0; j < values; j++)
+				EncodeValue(rawSample[j], sample[j]);
 		}
 		
-		delete(*nextSample);
+		if (ValidityChannel)
+			sample[values] = (T)validity[i];
 	}
+}
+
+
+//  Push the chunk to the outlet
+//
+void BroadcastData::PushChunk()
+{
+	if (ChunkCount == 0)
+		return;
 	
-	//  monitor performance, generate warning any time the queue is backed up more than one second
-	if(queueCount > SampleRate )
+	switch (Encoding)
 	{
-		Logging.AddLog("BroadcastData", "BroadcastDataToLslOutlet", format("Broadcast is more than one second behind. Queue size %d", queueCount), LogLevelWarn);
+	case LslDouble64:
+		LSLOutlet->push_chunk_multiplexed(ChunkSamples.data(), ChunkTimeStamps.data(), ChunkCount * SampleSize);
+		break;
+	case LslFloat32:
+		LSLOutlet->push_chunk_multiplexed(ChunkFloatSamples.data(), ChunkTimeStamps.data(), ChunkCount * SampleSize);
+		break;
+	case LslInt32:
+		LSLOutlet->push_chunk_multiplexed(ChunkIntSamples.data(), ChunkTimeStamps.data(), ChunkCount * SampleSize);
+		break;
 	}
+	ChunkCount = 0;
 }
 
+
+
+//  Send a gap event to the gap marker stream
+//  called from the data source thread
+//
+void BroadcastData::BroadcastGap(const SampleGap& gap)
+{
+	if (GapOutlet == NULL)
+		return;
+	
+	std::string marker = gap.AsJson().dump();
+	GapOutlet->push_sample(&marker);
+}
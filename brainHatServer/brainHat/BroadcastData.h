@@ -1,28 +1,72 @@
 #pragma once
-#include <queue>
+#include <vector>
+#include <functional>
 #include <condition_variable>
 #include <lsl_cpp.h>
 
 #include "Thread.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
+#include "SampleLayout.h"
+#include "SampleBus.h"
+#include "BoardDataSource.h"
+#include "TimeExtensions.h"
 
-typedef void(*ClientConnectionChangedCallbackFn)(bool);
+typedef std::function<void(bool)> ClientConnectionChangedCallbackFn;
+
+//  default longest chunk pushed to the LSL outlet, milliseconds of samples
+#define BROADCAST_CHUNKMS (100)
+
+//  int32 encoding scales, the value of one count for each kind of channel
+#define BROADCAST_INT32_EXGSCALE (0.01)
+#define BROADCAST_INT32_ACCELSCALE (0.000001)
+#define BROADCAST_INT32_OTHERSCALE (1.0)
+#define BROADCAST_INT32_ANALOGSCALE (1.0)
+
+
+//  Encoding of the LSL data stream
+//
+typedef enum
+{
+	LslDouble64,	//  double values, the board units
+	LslFloat32,		//  float values, the board units
+	LslInt32,		//  int32 counts, the value is the count times the channel scale in the stream description
+} LslEncoding;
+
+//  encoding names for command line arguments
+std::string LslEncodingName(LslEncoding encoding);
+bool ParseLslEncoding(std::string name, LslEncoding& encoding);
 
 //  UDP multicast thread for status broadcast
 //
-class BroadcastData : public Thread
+class BroadcastData : public Thread, public SampleBusSubscriber
 {
 public:
 	BroadcastData(ClientConnectionChangedCallbackFn fn);
 	virtual ~BroadcastData();
 	
-	void SetBoard(int boardId, int sampleRate);
+	//  set the board and the channel counts of its data source
+	void SetBoard(int boardId, int sampleRate, int exgChannels, int accelChannels, int otherChannels, int analogChannels);
 	
-	virtual void RunFunction();
+	//  name of the board when more than one board is served, call before SetBoard()
+	void SetDevice(std::string device) { Device = device; }
+	
+	//  add a validity channel after the time stamp, for boards with gap filling, call before SetBoard()
+	void SetValidityChannel(bool enable) { ValidityChannel = enable; }
 	
-	void AddData(BFSample* data);
+	//  longest chunk pushed to the outlet, call before SetBoard()
+	void SetMaxChunkDuration(int milliseconds) { MaxChunkMilliseconds = milliseconds; }
+	
+	//  stream encoding, and whether the time stamp is sent as a channel as well as the LSL time stamp, call before SetBoard()
+	//  the float32 and int32 encodings can not hold the time stamp, so it is only sent as the LSL time stamp
+	void SetEncoding(LslEncoding encoding, bool timeStampChannel) { Encoding = encoding; TimeStampChannel = timeStampChannel; }
+	
+	//  send a gap event to the gap marker stream
+	void BroadcastGap(const SampleGap& gap);
+	
+	virtual void RunFunction();
 	
 	bool HasClients() { return ClientsConnected; }
+
 	bool LslEnabled;
 
 protected:
@@ -30,22 +74,53 @@ protected:
 	//  LSL
 	void SetupLslForBoard();
 	lsl::stream_outlet* LSLOutlet;
+	lsl::stream_outlet* GapOutlet;
 	bool ClientsConnected;
+	bool ValidityChannel;
 		
 	int BoardId;
 	int SampleRate;
+	int ExgChannels;
+	int AccelChannels;
+	int OtherChannels;
+	int AnalogChannels;
 	int SampleSize;
+	int BlockSampleSize;
+	
+	//  block conversion for the board layout, and the raw sample buffer it fills
+	const SampleBlockFunctions* BlockFunctions;
+	std::vector<double> RawSamples;
+	
+	//  stream encoding
+	LslEncoding Encoding;
+	bool TimeStampChannel;
+	std::vector<double> ChannelScale;
+	
+	//  samples are pushed to the outlet a chunk at a time, with the LSL time stamp of each sample
+	int MaxChunkMilliseconds;
+	int MaxChunkSamples;
+	std::vector<double> ChunkSamples;
+	std::vector<float> ChunkFloatSamples;
+	std::vector<int32_t> ChunkIntSamples;
+	std::vector<double> ChunkTimeStamps;
+	int ChunkCount;
+	void AddToChunk(const SampleBlock* block, int first, int count, double lslClockOffset);
+	void PushChunk();
+	void AddChannelScale(lsl::xml_element& channel, int column);
+	template <typename T> void PackSamples(const double* raw, const unsigned char* validity, int count, T* chunk);
 	
 	std::string HostName;
+	std::string Device;
 	
-	//  queue lock
-	std::mutex QueueMutex;
-	std::queue<BFSample*> SamplesQueue;
+	//  sample bus
+	virtual void DataQueued();
+	ChronoTimer QueueStatsTimer;
 	
 	
 	int GetAvailableDataPort();
 	
 	void BroadcastDataToLslOutlet();
+	void BroadcastBatch(int count);
 	
 	ClientConnectionChangedCallbackFn ClientConnectionChangedCallback;
 	
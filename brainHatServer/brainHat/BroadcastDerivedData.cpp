@@ -0,0 +1,462 @@
+#include <string.h>
+#include <math.h>
+#include <lsl_cpp.h>
+#include <data_filter.h>
+#include <brainflow_exception.h>
+
+#include "brainHat.h"
+#include "BroadcastDerivedData.h"
+#include "StringExtensions.h"
+#include "NetworkExtensions.h"
+#include "BoardIds.h"
+
+using namespace std;
+
+
+//  Broadcast derived data thread
+//  Sends filtered, decimated and band power streams to the network using LSL
+//
+BroadcastDerivedData::BroadcastDerivedData() : SampleBusSubscriber("BroadcastDerivedData", SAMPLEQUEUE_CAPACITY, SAMPLEQUEUE_BATCH, OverflowDropOldest)
+{
+	FilteredOutlet = NULL;
+	DecimatedOutlet = NULL;
+	BandPowerOutlet = NULL;
+
+	BoardId = (int)BrainhatBoardIds::UNDEFINED;
+	SampleRate = 0;
+	ExgChannels = 0;
+
+	FiltersPrimed = false;
+	LastTimeStamp = 0.0;
+	DecimationFactor = 1;
+	DecimationPhase = 0;
+	Nfft = 0;
+	WindowSamples = 0;
+	WindowPosition = 0;
+	WindowFilled = 0;
+	BandPowerStep = 0;
+	SamplesToBandPower = 0;
+}
+
+
+//  Destructor
+//
+BroadcastDerivedData::~BroadcastDerivedData()
+{
+	Cancel();
+
+	if (FilteredOutlet != NULL)
+		delete FilteredOutlet;
+	if (DecimatedOutlet != NULL)
+		delete DecimatedOutlet;
+	if (BandPowerOutlet != NULL)
+		delete BandPowerOutlet;
+}
+
+
+//  Set board properties, and kick off the thread
+//
+bool BroadcastDerivedData::SetBoard(int boardId, int sampleRate, int exgChannels)
+{
+	BoardId = boardId;
+	SampleRate = sampleRate;
+	ExgChannels = exgChannels;
+
+	if (ExgChannels <= 0 || SampleRate <= 0)
+		return false;
+
+	if (Settings.DecimatedRate > 0 && (Settings.DecimatedRate >= SampleRate || SampleRate % Settings.DecimatedRate != 0))
+	{
+		Logging.AddLog("BroadcastDerivedData", "SetBoard", format("Decimated rate %d does not divide the sample rate %d.", Settings.DecimatedRate, SampleRate), LogLevelError);
+		return false;
+	}
+
+	if (Settings.HighPassHz <= 0.0 || Settings.LowPassHz <= Settings.HighPassHz || Settings.LowPassHz >= SampleRate / 2.0)
+	{
+		Logging.AddLog("BroadcastDerivedData", "SetBoard", format("Band pass %g to %g Hz is not valid at %d Hz.", Settings.HighPassHz, Settings.LowPassHz, SampleRate), LogLevelError);
+		return false;
+	}
+
+	//  filters for the board sample rate
+	ChannelFilters.resize(ExgChannels);
+	for (auto& filter : ChannelFilters)
+	{
+		filter.Clear();
+		filter.AddHighPass(SampleRate, Settings.HighPassHz, DERIVED_BANDPASSORDER);
+		filter.AddLowPass(SampleRate, Settings.LowPassHz, DERIVED_BANDPASSORDER);
+		if (Settings.NotchHz > 0.0 && Settings.NotchHz < SampleRate / 2.0)
+			filter.AddBandStop(SampleRate, Settings.NotchHz, Settings.NotchWidthHz, DERIVED_NOTCHORDER, DERIVED_NOTCHRIPPLEDB);
+	}
+
+	DecimationFactor = Settings.DecimatedRate > 0 ? SampleRate / Settings.DecimatedRate : 1;
+	AntiAliasFilters.resize(Settings.DecimatedRate > 0 ? ExgChannels : 0);
+	for (auto& filter : AntiAliasFilters)
+	{
+		filter.Clear();
+		filter.AddLowPass(SampleRate, Settings.DecimatedRate * DERIVED_ANTIALIASFRACTION, DERIVED_ANTIALIASORDER);
+	}
+
+	//  band power window is two FFT lengths, so the Welch PSD averages three half overlapped segments
+	if (Settings.BandPowerIntervalMs > 0)
+	{
+		Nfft = DataFilter::get_nearest_power_of_two(SampleRate);
+		WindowSamples = 2 * Nfft;
+		Window.assign(ExgChannels * WindowSamples, 0.0);
+		WindowLinear.resize(WindowSamples);
+		BandPowers.resize(ExgChannels * Settings.Bands.size());
+		BandPowerStep = (SampleRate * Settings.BandPowerIntervalMs) / 1000;
+		if (BandPowerStep < 1)
+			BandPowerStep = 1;
+	}
+
+	RestartFilters();
+
+	if (!SetupLslForBoard())
+		return false;
+
+	Thread::Start();
+
+	return true;
+}
+
+
+//  Make the stream info for one of the outlets, with the board fields
+//
+lsl::stream_info BroadcastDerivedData::MakeStreamInfo(string nameSuffix, string type, int channels, double rate, string sourceId)
+{
+	lsl::stream_info info(getSampleName(BoardId) + nameSuffix, type, channels, rate, lsl::cf_float32, sourceId);
+
+	info.desc().append_child_value("manufacturer", getManufacturerName(BoardId));
+	info.desc().append_child_value("boardId", format("%d", BoardId));
+	info.desc().append_child_value("device", Device);
+	info.desc().append_child_value("source", getSampleName(BoardId));
+	info.desc().append_child_value("sourceRate", format("%d", SampleRate));
+
+	return info;
+}
+
+
+//  Add the filters to the stream description
+//
+void BroadcastDerivedData::AddFilterDescription(lsl::stream_info& info)
+{
+	lsl::xml_element filter = info.desc().append_child("filter");
+	filter.append_child_value("type", "butterworth");
+	filter.append_child_value("highpass", format("%g", Settings.HighPassHz));
+	filter.append_child_value("lowpass", format("%g", Settings.LowPassHz));
+	filter.append_child_value("order", format("%d", DERIVED_BANDPASSORDER));
+	filter.append_child_value("notch", format("%g", Settings.NotchHz > 0.0 && Settings.NotchHz < SampleRate / 2.0 ? Settings.NotchHz : 0.0));
+	filter.append_child_value("notchWidth", format("%g", Settings.NotchWidthHz));
+	filter.append_child_value("notchType", "chebyshev1");
+	filter.append_child_value("notchOrder", format("%d", DERIVED_NOTCHORDER));
+	filter.append_child_value("notchRipple", format("%g", DERIVED_NOTCHRIPPLEDB));
+}
+
+
+//  Configure the LSL streams for the board
+//
+bool BroadcastDerivedData::SetupLslForBoard()
+{
+	string sourceId = Device.size() > 0 ? format("%s-%s", GetHostName().c_str(), Device.c_str()) : GetHostName();
+
+	if (Settings.Filtered)
+	{
+		lsl::stream_info info = MakeStreamInfo("Filtered", "EEG", ExgChannels, SampleRate, sourceId + "-filtered");
+		AddFilterDescription(info);
+
+		lsl::xml_element chns = info.desc().append_child("channels");
+		for (int k = 0; k < ExgChannels; k++)
+			chns.append_child("channel")
+			.append_child_value("label", format("ExgCh%d", k))
+			.append_child_value("unit", "uV")
+			.append_child_value("type", "EEG");
+
+		FilteredOutlet = new lsl::stream_outlet(info);
+	}
+
+	if (Settings.DecimatedRate > 0)
+	{
+		lsl::stream_info info = MakeStreamInfo("Decimated", "EEG", ExgChannels, Settings.DecimatedRate, sourceId + "-decimated");
+		AddFilterDescription(info);
+
+		lsl::xml_element decimation = info.desc().append_child("decimation");
+		decimation.append_child_value("factor", format("%d", DecimationFactor));
+		decimation.append_child_value("antialias", format("%g", Settings.DecimatedRate * DERIVED_ANTIALIASFRACTION));
+		decimation.append_child_value("order", format("%d", DERIVED_ANTIALIASORDER));
+
+		lsl::xml_element chns = info.desc().append_child("channels");
+		for (int k = 0; k < ExgChannels; k++)
+			chns.append_child("channel")
+			.append_child_value("label", format("ExgCh%d", k))
+			.append_child_value("unit", "uV")
+			.append_child_value("type", "EEG");
+
+		DecimatedOutlet = new lsl::stream_outlet(info);
+	}
+
+	if (Settings.BandPowerIntervalMs > 0)
+	{
+		int bands = (int)Settings.Bands.size();
+		lsl::stream_info info = MakeStreamInfo("BandPower", "BandPower", ExgChannels * bands, 1000.0 / Settings.BandPowerIntervalMs, sourceId + "-bandpower");
+		AddFilterDescription(info);
+
+		lsl::xml_element psd = info.desc().append_child("psd");
+		psd.append_child_value("method", "welch");
+		psd.append_child_value("window", "hanning");
+		psd.append_child_value("nfft", format("%d", Nfft));
+		psd.append_child_value("overlap", format("%d", Nfft / 2));
+		psd.append_child_value("samples", format("%d", WindowSamples));
+
+		lsl::xml_element bandList = info.desc().append_child("bands");
+		for (auto band : Settings.Bands)
+			bandList.append_child("band")
+			.append_child_value("low", format("%g", band.first))
+			.append_child_value("high", format("%g", band.second));
+
+		//  channel major, all the bands of the first channel, then the next channel
+		lsl::xml_element chns = info.desc().append_child("channels");
+		for (int k = 0; k < ExgChannels; k++)
+		{
+			for (auto band : Settings.Bands)
+				chns.append_child("channel")
+				.append_child_value("label", format("ExgCh%d_%g-%gHz", k, band.first, band.second))
+				.append_child_value("unit", "uV^2")
+				.append_child_value("type", "BandPower");
+		}
+
+		BandPowerOutlet = new lsl::stream_outlet(info);
+	}
+
+	Logging.AddLog("BroadcastDerivedData", "SetupLslForBoard", format("Derived streams for board %d:%s%s%s.", BoardId, Settings.Filtered ? " filtered" : "", Settings.DecimatedRate > 0 ? format(" decimated to %d Hz", Settings.DecimatedRate).c_str() : "", Settings.BandPowerIntervalMs > 0 ? format(" band power every %d ms", Settings.BandPowerIntervalMs).c_str() : ""), LogLevelInfo);
+
+	return true;
+}
+
+
+
+//  Only take data from the bus while one of the outlets has consumers
+//  called in the publishing thread
+//
+bool BroadcastDerivedData::AcceptsData()
+{
+	return (FilteredOutlet != NULL && FilteredOutlet->have_consumers())
+		|| (DecimatedOutlet != NULL && DecimatedOutlet->have_consumers())
+		|| (BandPowerOutlet != NULL && BandPowerOutlet->have_consumers());
+}
+
+
+//  Data was queued by the sample bus, wake up the thread
+//
+void BroadcastDerivedData::DataQueued()
+{
+	RunSignal.Notify();
+}
+
+
+//  Run function
+//  processes data from the queue, sleeps until the sample bus signals there is more
+//
+void BroadcastDerivedData::RunFunction()
+{
+	QueueStatsTimer.Start();
+
+	while (ThreadRunning)
+	{
+		RunSignal.WaitFor(5000 - QueueStatsTimer.ElapsedMilliseconds());
+
+		int count;
+		while ((count = TakeBatch()) > 0)
+		{
+			double lslClockOffset = lsl::local_clock() - GetUnixTimeSeconds();
+
+			for (int i = 0; i < count; i++)
+			{
+				ProcessBlock(Batch[i], lslClockOffset);
+				Batch[i]->Release();
+			}
+		}
+
+		if (QueueStatsTimer.ElapsedMilliseconds() >= 5000)
+		{
+			LogQueueStatistics(GetWakeups(), QueueStatsTimer.ElapsedSeconds());
+			QueueStatsTimer.Reset();
+		}
+	}
+}
+
+
+//  Start the filters again, after a gap in the data
+//
+void BroadcastDerivedData::RestartFilters()
+{
+	FiltersPrimed = false;
+	DecimationPhase = 0;
+	WindowPosition = 0;
+	WindowFilled = 0;
+	SamplesToBandPower = BandPowerStep;
+}
+
+
+//  Filter a block, and push the derived samples to the outlets
+//
+void BroadcastDerivedData::ProcessBlock(const SampleBlock* block, double lslClockOffset)
+{
+	int count = block->GetNumberOfSamples();
+	if (count == 0)
+		return;
+
+	//  the outlets had no consumers, the stream was stopped, or blocks were dropped
+	const double* timeStamps = block->TimeStampRow();
+	if (LastTimeStamp == 0.0 || timeStamps[0] < LastTimeStamp || timeStamps[0] - LastTimeStamp > DERIVED_RESTARTSECONDS)
+		RestartFilters();
+	LastTimeStamp = timeStamps[count - 1];
+
+	if ((int)FilteredRows.size() < ExgChannels * count)
+		FilteredRows.resize(ExgChannels * count);
+	if ((int)Chunk.size() < ExgChannels * count)
+		Chunk.resize(ExgChannels * count);
+	if ((int)ChunkTimeStamps.size() < count)
+		ChunkTimeStamps.resize(count);
+
+	//  start from the first sample of each channel, so the filters do not ring from the electrode offset
+	if (!FiltersPrimed)
+	{
+		for (int c = 0; c < ExgChannels; c++)
+		{
+			double first = block->ExgRow(c)[0];
+			ChannelFilters[c].Prime(isnan(first) ? 0.0 : first);
+		}
+		FiltersPrimed = true;
+	}
+
+	//  one channel at a time, so each row is read and written in order
+	for (int c = 0; c < ExgChannels; c++)
+		ChannelFilters[c].Process(block->ExgRow(c), FilteredRows.data() + (c * count), count);
+
+	if (FilteredOutlet != NULL && FilteredOutlet->have_consumers())
+	{
+		for (int c = 0; c < ExgChannels; c++)
+		{
+			const double* row = FilteredRows.data() + (c * count);
+			for (int s = 0; s < count; s++)
+				Chunk[(s * ExgChannels) + c] = (float)row[s];
+		}
+		for (int s = 0; s < count; s++)
+			ChunkTimeStamps[s] = timeStamps[s] + lslClockOffset;
+
+		FilteredOutlet->push_chunk_multiplexed(Chunk.data(), ChunkTimeStamps.data(), ExgChannels * count);
+	}
+
+	if (DecimatedOutlet != NULL)
+	{
+		//  the anti alias filters run on every sample, only the kept samples are sent
+		AntiAliasRow.resize(count);
+		int kept = 0;
+		for (int c = 0; c < ExgChannels; c++)
+		{
+			AntiAliasFilters[c].Process(FilteredRows.data() + (c * count), AntiAliasRow.data(), count);
+
+			kept = 0;
+			for (int s = DecimationPhase; s < count; s += DecimationFactor)
+				Chunk[(kept++ * ExgChannels) + c] = (float)AntiAliasRow[s];
+		}
+
+		kept = 0;
+		for (int s = DecimationPhase; s < count; s += DecimationFactor)
+			ChunkTimeStamps[kept++] = timeStamps[s] + lslClockOffset;
+		DecimationPhase = (DecimationPhase + (kept * DecimationFactor)) - count;
+
+		if (kept > 0 && DecimatedOutlet->have_consumers())
+			DecimatedOutlet->push_chunk_multiplexed(Chunk.data(), ChunkTimeStamps.data(), ExgChannels * kept);
+	}
+
+	if (BandPowerOutlet != NULL)
+	{
+		//  the window is filled in pieces, so a band power is calculated at every interval
+		int first = 0;
+		while (first < count)
+		{
+			int add = count - first;
+			if (add > SamplesToBandPower)
+				add = SamplesToBandPower;
+
+			for (int c = 0; c < ExgChannels; c++)
+			{
+				const double* row = FilteredRows.data() + (c * count) + first;
+				double* window = Window.data() + (c * WindowSamples);
+				for (int s = 0, position = WindowPosition; s < add; s++)
+				{
+					window[position] = row[s];
+					if (++position == WindowSamples)
+						position = 0;
+				}
+			}
+			AddToWindow(add);
+
+			first += add;
+			SamplesToBandPower -= add;
+			if (SamplesToBandPower == 0)
+			{
+				SamplesToBandPower = BandPowerStep;
+				if (WindowFilled == WindowSamples && BandPowerOutlet->have_consumers() && CalculateBandPowers())
+					BandPowerOutlet->push_sample(BandPowers.data(), timeStamps[first - 1] + lslClockOffset);
+			}
+		}
+	}
+}
+
+
+//  Move the window position on, after count samples were written to each channel
+//
+void BroadcastDerivedData::AddToWindow(int count)
+{
+	WindowPosition = (WindowPosition + count) % WindowSamples;
+	WindowFilled += count;
+	if (WindowFilled > WindowSamples)
+		WindowFilled = WindowSamples;
+}
+
+
+//  Calculate the band powers of each channel over the window, the same way the client band power calculator does
+//
+bool BroadcastDerivedData::CalculateBandPowers()
+{
+	int bands = (int)Settings.Bands.size();
+
+	for (int c = 0; c < ExgChannels; c++)
+	{
+		//  oldest sample first, a channel with a NaN in the window has no band power
+		const double* window = Window.data() + (c * WindowSamples);
+		memcpy(WindowLinear.data(), window + WindowPosition, (WindowSamples - WindowPosition) * sizeof(double));
+		memcpy(WindowLinear.data() + (WindowSamples - WindowPosition), window, WindowPosition * sizeof(double));
+
+		bool valid = true;
+		for (int s = 0; s < WindowSamples && valid; s++)
+			valid = !isnan(WindowLinear[s]);
+
+		if (!valid)
+		{
+			for (int b = 0; b < bands; b++)
+				BandPowers[(c * bands) + b] = NAN;
+			continue;
+		}
+
+		try
+		{
+			auto psd = DataFilter::get_psd_welch(WindowLinear.data(), WindowSamples, Nfft, Nfft / 2, SampleRate, (int)WindowFunctions::HANNING);
+
+			for (int b = 0; b < bands; b++)
+				BandPowers[(c * bands) + b] = (float)DataFilter::get_band_power(psd, Nfft / 2 + 1, Settings.Bands[b].first, Settings.Bands[b].second);
+
+			delete[] psd.first;
+			delete[] psd.second;
+		}
+		catch (const BrainFlowException &err)
+		{
+			Logging.AddLog("BroadcastDerivedData", "CalculateBandPowers", format("Failed to calculate band power. Error %d %s.", err.exit_code, err.what()), LogLevelError);
+			return false;
+		}
+	}
+
+	return true;
+}
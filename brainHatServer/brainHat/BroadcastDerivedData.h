@@ -0,0 +1,144 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <lsl_cpp.h>
+
+#include "Thread.h"
+#include "SampleBlock.h"
+#include "SampleBus.h"
+#include "SignalFilter.h"
+#include "TimeExtensions.h"
+
+//  filter order of the band pass edges, and of the anti alias low pass before decimation
+#define DERIVED_BANDPASSORDER (2)
+#define DERIVED_ANTIALIASORDER (4)
+
+//  notch, a Chebyshev type I band stop of the same order and ripple as the client default 60 Hz filter
+#define DERIVED_NOTCHORDER (6)
+#define DERIVED_NOTCHRIPPLEDB (1.0)
+
+//  anti alias cutoff, fraction of the decimated sample rate
+#define DERIVED_ANTIALIASFRACTION (0.4)
+
+//  gap in the sample time stamps that restarts the filters
+#define DERIVED_RESTARTSECONDS (1.0)
+
+
+//  Derived stream settings, from the command line
+//
+struct DerivedStreamSettings
+{
+public:
+
+	//  filtered stream, band pass and optional notch, the other streams are made from the filtered data
+	//  the defaults are the band pass and band stop of the client default filter, the client wavelet denoising is not done here
+	bool Filtered;
+	double HighPassHz;
+	double LowPassHz;
+	double NotchHz;
+	double NotchWidthHz;
+	//
+	//  decimated stream sample rate, zero for none, must divide the board sample rate
+	int DecimatedRate;
+	//
+	//  band power stream, milliseconds between band powers, zero for none
+	int BandPowerIntervalMs;
+	std::vector<std::pair<double, double>> Bands;
+
+	DerivedStreamSettings()
+	{
+		Filtered = false;
+		HighPassHz = 2.0;
+		LowPassHz = 49.0;
+		NotchHz = 60.0;
+		NotchWidthHz = 2.0;
+		DecimatedRate = 0;
+		BandPowerIntervalMs = 0;
+		Bands = { { 1.0, 4.0 }, { 4.0, 8.0 }, { 8.0, 13.0 }, { 13.0, 30.0 }, { 30.0, 45.0 } };
+	}
+
+	bool Enabled() { return Filtered || DecimatedRate > 0 || BandPowerIntervalMs > 0; }
+};
+
+
+//  Broadcast Derived Data
+//  Publishes LSL outlets made from the board EXG channels, so clients do not each filter the same data
+//    -  Filtered, Butterworth band pass and Chebyshev band stop notch filtered at the board sample rate
+//    -  Decimated, the filtered data through an anti alias low pass, at a lower sample rate
+//    -  BandPower, the power in each band for each channel, from the Welch PSD of the last two FFT lengths of filtered data
+//  the filters and band settings are in the stream descriptions
+//
+//  it is a subscriber to the sample bus with its own thread, it only takes data while one of its outlets has consumers
+//
+class BroadcastDerivedData : public Thread, public SampleBusSubscriber
+{
+public:
+	BroadcastDerivedData();
+	virtual ~BroadcastDerivedData();
+
+	//  set the streams, call before SetBoard()
+	void SetStreams(DerivedStreamSettings settings) { Settings = settings; }
+
+	//  name of the board when more than one board is served, call before SetBoard()
+	void SetDevice(std::string device) { Device = device; }
+
+	//  set the board and the channel counts of its data source, and kick off the thread, returns false if the streams can not be made
+	bool SetBoard(int boardId, int sampleRate, int exgChannels);
+
+	virtual void RunFunction();
+
+protected:
+
+	DerivedStreamSettings Settings;
+	std::string Device;
+
+	int BoardId;
+	int SampleRate;
+	int ExgChannels;
+
+	//  LSL
+	lsl::stream_outlet* FilteredOutlet;
+	lsl::stream_outlet* DecimatedOutlet;
+	lsl::stream_outlet* BandPowerOutlet;
+	bool SetupLslForBoard();
+	lsl::stream_info MakeStreamInfo(std::string nameSuffix, std::string type, int channels, double rate, std::string sourceId);
+	void AddFilterDescription(lsl::stream_info& info);
+
+	//  filters, one chain for each channel
+	std::vector<FilterChain> ChannelFilters;
+	std::vector<FilterChain> AntiAliasFilters;
+	bool FiltersPrimed;
+	double LastTimeStamp;
+	void RestartFilters();
+
+	//  filtered block, one row for each channel, and the chunk pushed to the outlet
+	std::vector<double> FilteredRows;
+	std::vector<double> AntiAliasRow;
+	std::vector<float> Chunk;
+	std::vector<double> ChunkTimeStamps;
+
+	//  decimation, position of the next sample kept
+	int DecimationFactor;
+	int DecimationPhase;
+
+	//  band power, a window of filtered data for each channel
+	int Nfft;
+	int WindowSamples;
+	int WindowPosition;
+	int WindowFilled;
+	int BandPowerStep;
+	int SamplesToBandPower;
+	std::vector<double> Window;
+	std::vector<double> WindowLinear;
+	std::vector<float> BandPowers;
+	void AddToWindow(int count);
+	bool CalculateBandPowers();
+
+	void ProcessBlock(const SampleBlock* block, double lslClockOffset);
+
+	//  sample bus
+	virtual bool AcceptsData();
+	virtual void DataQueued();
+	ChronoTimer QueueStatsTimer;
+};
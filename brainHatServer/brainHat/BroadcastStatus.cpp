@@ -5,6 +5,7 @@
 
 #include "brainHat.h"
 #include "BroadcastStatus.h"
+#include "BoardSession.h"
 #include "BrainHatServerStatus.h"
 #include "StringExtensions.h"
 #include "TimeExtensions.h"
@@ -70,7 +71,8 @@ int CheckIpConfigTimeout = (60 * 1000);
 //
 BroadcastStatus::BroadcastStatus()
 {
-	
+	Session = NULL;
+	LSLOutlet = NULL;
 	
 	Eth0Address = "";
 	Wlan0Address = "";
@@ -86,8 +88,9 @@ BroadcastStatus::~BroadcastStatus()
 
 
 
-void BroadcastStatus::StartBroadcast(int boardId, int sampleRate)
+void BroadcastStatus::StartBroadcast(BoardSession* session, int boardId, int sampleRate)
 {
+	Session = session;
 	BoardId = boardId;
 	SampleRate = sampleRate;
 	HostName = GetHostName();
@@ -103,10 +106,14 @@ void BroadcastStatus::StartBroadcast(int boardId, int sampleRate)
 
 void BroadcastStatus::SetupLslForStatus()
 {
-	lsl::stream_info info("bhStatus", "bhStatus", 1, lsl::IRREGULAR_RATE, lsl::cf_string, HostName);
+	string device = Session->GetDevice();
+	string sourceId = device.size() > 0 ? format("%s-%s", HostName.c_str(), device.c_str()) : HostName;
+	
+	lsl::stream_info info("bhStatus", "bhStatus", 1, lsl::IRREGULAR_RATE, lsl::cf_string, sourceId);
 
 	info.desc().append_child_value("boardId", format("%d", BoardId));
 	info.desc().append_child_value("sampleRate", format("%d", SampleRate));
+	info.desc().append_child_value("device", device);
 
 	LSLOutlet = new lsl::stream_outlet(info);
 	
@@ -132,6 +139,7 @@ void BroadcastStatus::SetIpConfig()
 
 
 //  Run function
+//  the thread only wakes up when one of the timers is due, or to shut down
 //
 void BroadcastStatus::RunFunction()
 {
@@ -149,7 +157,10 @@ void BroadcastStatus::RunFunction()
 			BroadcastStatusTimer.Reset();
 		}
 
-		Sleep(1);
+		//  sleep until the next timer is due
+		int waitIpConfig = CheckIpConfigTimeout - CheckIpConfigTimer.ElapsedMilliseconds();
+		int waitStatus = BroadcastTimeoutStatus - BroadcastStatusTimer.ElapsedMilliseconds();
+		RunSignal.WaitFor(waitIpConfig < waitStatus ? waitIpConfig : waitStatus);
 	}
 }
 
@@ -169,17 +180,11 @@ void BroadcastStatus::BroadcastStatusOverMulticast()
 		status.Wlan0Address  = Wlan0Address;
 		status.Wlan0Mode = Wlan0Mode;
 	
-	
-		status.RecordingDataBrainHat = FileWriter != NULL ? FileWriter->IsRecording() : false;
-		status.RecordingFileNameBrainHat = FileWriter != NULL ? (FileWriter->IsRecording() ? FileWriter->FileName() : "") : "";
-		status.RecordingDurationBrainHat = FileWriter != NULL ? (FileWriter->IsRecording() ? FileWriter->ElapsedRecordingTime() : 0.0) : 0.0;
-	
-		if (DataSource != NULL)
-		{
-			status.CytonSRB1 = DataSource->GetSrb1(0);
-			status.DaisySRB1 = DataSource->GetSrb1(1);
-			status.IsStreaming = DataSource->GetIsStreamRunning();
-		}
+		//  board, recording and queue status
+		Session->GetStatus(status);
+		status.LogQueueDepth = Logging.GetQueueDepth();
+		status.LogQueueMaxDepth = Logging.GetQueueMaxDepth();
+		status.LogsDropped = Logging.GetDroppedLogs();
 	
 		status.UnixTimeMillis = GetUnixTimeMilliseconds();
 	
@@ -1,8 +1,10 @@
 #pragma once
 #include <queue>
+#include <lsl_cpp.h>
 #include "TimeExtensions.h"
 #include "Thread.h"
 
+class BoardSession;
 
 //  UDP multicast thread for status broadcast
 //
@@ -12,13 +14,14 @@ public:
 	BroadcastStatus();
 	virtual ~BroadcastStatus();
 
-	void StartBroadcast(int boardId, int sampleRate);
+	void StartBroadcast(BoardSession* session, int boardId, int sampleRate);
 	
 	virtual void RunFunction();
 	
 		
 protected:
 	
+	BoardSession* Session;
 	int BoardId;
 	int SampleRate;
 	void SetupLslForStatus();
@@ -0,0 +1,508 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <poll.h>
+#include <errno.h>
+
+#include "brainHat.h"
+#include "ContecDataReader.h"
+#include "StringExtensions.h"
+#include "BoardIds.h"
+#include "SerialPort.h"
+
+//  serial port wait for data, milliseconds
+#define SERIAL_POLL (20)
+
+//  size of the device info response
+#define CONTEC_INFOSIZE (41)
+
+using namespace std;
+
+
+//  Frame unpacking tables
+//  each group of three bytes b0 b1 b2 holds two values
+//    first  = b0 + (low three bits of b1 * 256), negative when bit 3 of b1 is set
+//    second = (high four bits of b1) + (low seven bits of b2 * 16), negative when bit 3 of b2 is set
+//  so each value is the sum of one entry for each byte, times the sign for the byte holding the sign bit
+//
+struct ContecUnpackTables
+{
+	short FirstHigh[256];
+	short SecondLow[256];
+	short SecondHigh[256];
+	short Sign[256];
+
+	ContecUnpackTables()
+	{
+		for (int b = 0; b < 256; b++)
+		{
+			FirstHigh[b] = (b & 0x07) * 256;
+			SecondLow[b] = (b & 0xF0) >> 4;
+			SecondHigh[b] = (b & 0x7F) * 16;
+			Sign[b] = (b & 0x08) ? -1 : 1;
+		}
+	}
+};
+
+static const ContecUnpackTables UnpackTables;
+
+
+//  Contec Data Reader, reads frames from the serial port
+//  Construct with callback functions:
+//    -  ConnectionChanged will be called on first discovery of board parameters, then on connect / disconnect state
+//    -  NewSample will be called when new data is read from the board
+//
+ContecDataReader::ContecDataReader(ConnectionChangedCallbackFn connectionChangedFn, NewSampleCallbackFn newSampleFn)
+{
+	Init();
+
+	ConnectionChangedCallback = connectionChangedFn;
+	NewSampleCallback = newSampleFn;
+}
+
+
+//  Destructor
+//
+ContecDataReader::~ContecDataReader()
+{
+	Cancel();
+}
+
+
+//  Initialize properties
+//
+void ContecDataReader::Init()
+{
+	SerialPort = -1;
+	BoardOn = true;
+	IsConnected = false;
+	StreamRunning = false;
+	ConnectionChangedCallback = NULL;
+	ConnectionChangedDelegate = NULL;
+	ReadBufferCount = 0;
+	DiscardedBytes = 0;
+	FrameCounter = 0;
+
+	BoardDataSource::Init();
+}
+
+
+//  Describe the source of the data
+//
+string ContecDataReader::ReportSource()
+{
+	return format("Contec at %d Hz on %s.", SampleRate, SerialPortName.c_str());
+}
+
+
+//  Thread Start
+//
+int ContecDataReader::Start(int boardId, struct BrainFlowInputParams params, bool srb1On)
+{
+	SerialPortName = params.serial_port;
+	BoardId = boardId;
+
+	LastSampleIndex = -1;
+
+	Thread::Start();
+
+	return 0;
+}
+
+
+//  Thread Cancel
+//
+void ContecDataReader::Cancel()
+{
+	Thread::Cancel();
+
+	ReleaseBoard();
+}
+
+
+//  Public funciton to toggle streaming
+//
+bool ContecDataReader::RequestEnableStreaming(bool enable)
+{
+	if ((enable && !StreamRunning) || (!enable && StreamRunning))
+		RequestToggleStreaming = true;
+
+	return true;
+}
+
+
+//  Initialize Board
+//  opens the serial port, runs the command sequence the Contec software sends before streaming, and starts streaming data
+//
+int ContecDataReader::InitializeBoard()
+{
+	ReleaseBoard();
+	RequestToggleStreaming = false;
+
+	SerialPort = serialOpen(SerialPortName.c_str(), 921600, 1);
+	if (SerialPort < 0)
+	{
+		Logging.AddLog("ContecDataReader", "InitializeBoard", format("Failed to open serial port %s.", SerialPortName.c_str()), LogLevelDebug);
+		SerialPort = -1;
+		return -1;
+	}
+
+	//  stop any stream left running
+	WriteCommand(CONTEC_COMMAND_STOP);
+	usleep(100 * USLEEP_MILI);
+	serialFlush(SerialPort);
+
+	if (!SendCommand(CONTEC_COMMAND_INFO, CONTEC_INFOSIZE, 1000) || !SendCommand(CONTEC_COMMAND_INIT3, 2, 1000) || !SendCommand(CONTEC_COMMAND_INIT6, 2, 1000))
+	{
+		Logging.AddLog("ContecDataReader", "InitializeBoard", "Device did not respond to the initialization commands.", LogLevelDebug);
+		ReleaseBoard();
+		return -1;
+	}
+
+	bool newConnection = SampleRate < 0;
+	if (newConnection)
+	{
+		DataRows = getNumberOfRows(BoardId);
+		SampleRate = getSamplingRate(BoardId);
+
+		ExgChannelCount = getNumberOfExgChannels(BoardId);
+		AccelChannelCount = getNumberOfAccelChannels(BoardId);
+		OtherChannelCount = getNumberOfOtherChannels(BoardId);
+		AnalogChannelCount = getNumberOfAnalogChannels(BoardId);
+
+		ConfigureBlockPool();
+		TimeEstimator.Configure(SampleRate, 1);
+	}
+
+	ConnectionChanged(newConnection ? New : Connected, BoardId, SampleRate);
+
+	StartStreaming();
+
+	InitializeDataReadCounters();
+
+	ValidDataTimer.Start();
+	IsConnected = true;
+	Logging.AddLog("ContecDataReader", "InitializeBoard", format("Connected to Contec on %s. Sample rate %d.", SerialPortName.c_str(), SampleRate), LogLevelInfo);
+
+	return 0;
+}
+
+
+// Initialize the data reading monitor counters
+//
+void ContecDataReader::InitializeDataReadCounters()
+{
+	LastSampleIndex = -1;
+	LastTimeStampSync = -1;
+	ReadBufferCount = 0;
+	TimeEstimator.Reset();
+	ResetGapDetection();
+	InspectDataStreamLogTimer.Start();
+	TimeEstimatorLogTimer.Start();
+}
+
+
+//  Release Board
+//  stops the stream and closes the serial port
+//
+void ContecDataReader::ReleaseBoard()
+{
+	if (SerialPort >= 0)
+	{
+		StopStreaming();
+		serialClose(SerialPort);
+		SerialPort = -1;
+		ConnectionChanged(Disconnected, BoardId, SampleRate);
+	}
+
+	IsConnected = false;
+}
+
+
+//  Start board streaming
+//  the device acknowledges the start command, the acknowledgement is skipped by the frame decoder
+//
+void ContecDataReader::StartStreaming()
+{
+	if (!StreamRunning && BoardReady())
+	{
+		Logging.AddLog("ContecDataReader", "StartStreaming", "Starting data stream.", LogLevelInfo);
+		serialFlush(SerialPort);
+		ReadBufferCount = 0;
+		WriteCommand(CONTEC_COMMAND_START);
+
+		StreamRunning = true;
+		ValidDataTimer.Reset();
+		ConnectionChanged(StreamOn, BoardId, SampleRate);
+	}
+}
+
+
+//  Stop board streaming
+//
+void ContecDataReader::StopStreaming()
+{
+	if (StreamRunning && BoardReady())
+	{
+		Logging.AddLog("ContecDataReader", "StopStreaming", "Stopping data stream.", LogLevelInfo);
+		WriteCommand(CONTEC_COMMAND_STOP);
+		usleep(100 * USLEEP_MILI);
+		serialFlush(SerialPort);
+
+		StreamRunning = false;
+		ConnectionChanged(StreamOff, BoardId, SampleRate);
+	}
+}
+
+
+//  Write a command to the device
+//
+void ContecDataReader::WriteCommand(unsigned char command)
+{
+	if (BoardReady())
+	{
+		serialPutchar(SerialPort, CONTEC_COMMAND);
+		serialPutchar(SerialPort, command);
+	}
+}
+
+
+//  Send a command to the device, with the stream stopped, and read the response
+//
+bool ContecDataReader::SendCommand(unsigned char command, int responseSize, int timeoutMs)
+{
+	if (!BoardReady())
+		return false;
+
+	WriteCommand(command);
+
+	unsigned char response[CONTEC_INFOSIZE];
+	int received = 0;
+
+	ChronoTimer timer;
+	timer.Start();
+	while (received < responseSize && timer.ElapsedMilliseconds() < timeoutMs)
+	{
+		struct pollfd pfd = { SerialPort, POLLIN, 0 };
+		if (poll(&pfd, 1, SERIAL_POLL) <= 0)
+			continue;
+
+		int count = read(SerialPort, response + received, responseSize - received);
+		if (count < 0)
+			return false;
+
+		received += count;
+	}
+
+	if (received < 2 || response[0] != CONTEC_RESPONSE || response[1] != command)
+	{
+		Logging.AddLog("ContecDataReader", "SendCommand", format("No response to command %02x.", command), LogLevelDebug);
+		return false;
+	}
+
+	return true;
+}
+
+
+//  Reconnect to Board
+//
+void ContecDataReader::EstablishConnectionWithBoard()
+{
+	if (!BoardReady())
+	{
+		if (InitializeBoard() != 0)
+			usleep(3*USLEEP_SEC);
+	}
+}
+
+
+//  Check conditions are OK to read data from the board
+//
+bool ContecDataReader::PreparedToReadBoard()
+{
+	if (!BoardOn)
+	{
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+
+	//  make sure we are connected to the board
+	EstablishConnectionWithBoard();
+
+	if (!BoardReady())
+	{
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+	else if (RequestToggleStreaming)
+	{
+		if (StreamRunning)
+			StopStreaming();
+		else
+			StartStreaming();
+
+		RequestToggleStreaming = false;
+		return false;
+	}
+	else if (!StreamRunning)
+	{
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+	else if (ValidDataTimer.ElapsedMilliseconds() > 3000)
+	{
+		//  have not received fresh samples in three seconds, close the port and reinitialize
+		Logging.AddLog("ContecDataReader", "PreparedToReadBoard", "Too long without valid sample. Reconnecting to board.", LogLevelError);
+		ReconnectStarted(ValidDataTimer.ElapsedMilliseconds());
+		ReleaseBoard();
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+
+	return true;
+}
+
+
+//  Board reading / control thread run function
+//
+void ContecDataReader::RunFunction()
+{
+	while (ThreadRunning)
+	{
+		if (!PreparedToReadBoard())
+			continue;
+
+		ReadSerialData();
+	}
+}
+
+
+//  Wait for data on the serial port, read it into the buffer and decode the whole frames
+//
+void ContecDataReader::ReadSerialData()
+{
+	struct pollfd pfd = { SerialPort, POLLIN, 0 };
+	if (poll(&pfd, 1, SERIAL_POLL) <= 0)
+		return;
+
+	int count = read(SerialPort, ReadBuffer + ReadBufferCount, CONTEC_BUFFERSIZE - ReadBufferCount);
+	if (count < 0)
+	{
+		Logging.AddLog("ContecDataReader", "ReadSerialData", format("Failed to read serial port. Error %d.", errno), LogLevelError);
+		ReleaseBoard();
+		return;
+	}
+
+	ReadBufferCount += count;
+	if (ReadBufferCount < CONTEC_FRAMESIZE)
+		return;
+
+	auto block = BlockPool.Get(ReadBufferCount / CONTEC_FRAMESIZE);
+	if (DecodeFrames(block) > 0)
+		ProcessData(block);
+	else
+		block->Release();
+}
+
+
+//  Process a block of decoded samples
+//  send to broadcast thread and logging if enabled
+//
+void ContecDataReader::ProcessData(SampleBlock* block)
+{
+	ValidDataTimer.Reset();
+	ReconnectFinished();
+
+	//  sample times from the fit of the frame count to the clock
+	TimeEstimator.AddChunk(block->SampleIndexRow(), block->GetNumberOfSamples(), block->TimeStampRow());
+	LogTimeEstimator();
+
+	//  inspect data stream
+	InspectDataStream(block);
+
+	//  publish the block, consumers hold their own references
+	NewSample(block);
+	block->Release();
+}
+
+
+//  Check the bytes at the start of the buffer are a frame, the start byte followed by bytes with the top bit clear
+//
+inline bool IsContecFrame(const unsigned char* frame)
+{
+	if (frame[0] != CONTEC_STARTBYTE)
+		return false;
+
+	unsigned char topBits = 0;
+	for (int i = 1; i < CONTEC_FRAMESIZE; i++)
+		topBits |= frame[i];
+
+	return (topBits & 0x80) == 0;
+}
+
+
+//  Decode the whole frames in the read buffer into the block
+//  a byte that does not start a frame is skipped, so the decoder finds the next frame after command responses or noise on the line
+//  the bytes of a partial frame are kept for the next read
+//
+int ContecDataReader::DecodeFrames(SampleBlock* block)
+{
+	int samples = 0;
+	int position = 0;
+
+	while (ReadBufferCount - position >= CONTEC_FRAMESIZE)
+	{
+		const unsigned char* frame = ReadBuffer + position;
+		if (!IsContecFrame(frame))
+		{
+			position++;
+			DiscardedBytes++;
+			continue;
+		}
+
+		DecodeFrame(frame, block, samples);
+		samples++;
+		position += CONTEC_FRAMESIZE;
+	}
+
+	ReadBufferCount -= position;
+	if (ReadBufferCount > 0)
+		memmove(ReadBuffer, ReadBuffer + position, ReadBufferCount);
+
+	block->SetNumberOfSamples(samples);
+	if (samples > 0)
+		memset(block->ValidityRow(), 1, samples);
+
+	return samples;
+}
+
+
+//  Decode one frame, the twenty values from the ten groups of three bytes, and the trailer byte
+//
+void ContecDataReader::DecodeFrame(const unsigned char* frame, SampleBlock* block, int sample)
+{
+	block->SampleIndexRow()[sample] = FrameCounter;
+	FrameCounter = (FrameCounter + 1) % 256;
+
+	const unsigned char* group = frame + 1;
+	for (int i = 0; i < CONTEC_GROUPS; i++, group += 3)
+	{
+		block->ExgRow(2 * i)[sample] = (group[0] + UnpackTables.FirstHigh[group[1]]) * UnpackTables.Sign[group[1]];
+		block->ExgRow((2 * i) + 1)[sample] = (UnpackTables.SecondLow[group[1]] + UnpackTables.SecondHigh[group[2]]) * UnpackTables.Sign[group[2]];
+	}
+
+	if (OtherChannelCount > 0)
+		block->OtherRow(0)[sample] = frame[CONTEC_FRAMESIZE - 1];
+}
+
+
+//  Log the sample time fit
+//
+void ContecDataReader::LogTimeEstimator()
+{
+	if (TimeEstimatorLogTimer.ElapsedMilliseconds() < 5000)
+		return;
+
+	TimeEstimatorLogTimer.Reset();
+	Logging.AddLog("ContecDataReader", "LogTimeEstimator", format("Sample clock drift %.1lf ppm, read jitter %.1lf ms, %d reads in fit, %d bytes discarded.", TimeEstimator.GetDriftPpm(), TimeEstimator.GetResidual() * 1000.0, TimeEstimator.GetWindowSize(), DiscardedBytes), LogLevelTrace);
+}
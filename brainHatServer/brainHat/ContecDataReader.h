@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+
+#include "BoardDataSource.h"
+#include "SampleBlock.h"
+#include "TimeExtensions.h"
+#include "SampleTimeEstimator.h"
+
+//  Contec serial frame
+//  start byte, ten groups of three bytes each holding two 11 bit signed values, trailer byte
+//  every byte after the start byte has the top bit clear
+#define CONTEC_FRAMESIZE (32)
+#define CONTEC_STARTBYTE (0xA0)
+#define CONTEC_GROUPS (10)
+
+//  Contec commands, the device answers 0xE0 and the command byte
+#define CONTEC_COMMAND (0x90)
+#define CONTEC_RESPONSE (0xE0)
+#define CONTEC_COMMAND_START (0x01)
+#define CONTEC_COMMAND_STOP (0x02)
+#define CONTEC_COMMAND_INIT3 (0x03)
+#define CONTEC_COMMAND_INIT6 (0x06)
+#define CONTEC_COMMAND_INFO (0x09)
+
+//  size of the serial read buffer, about a quarter second of frames
+#define CONTEC_BUFFERSIZE (CONTEC_FRAMESIZE * 64)
+
+
+//  Contec Data Reader
+//  Reads the Contec amplifier over the serial port, and decodes the frames into sample blocks
+//
+//  the device does not send a sample number, so the reader numbers the frames itself (rolling over at 256 like the Cyton),
+//  lost frames can not be detected, and the values are the raw counts from the frame
+//
+class ContecDataReader : public BoardDataSource
+{
+public:
+	ContecDataReader(ConnectionChangedCallbackFn connectionChangedFn, NewSampleCallbackFn newSampleFn);
+	virtual ~ContecDataReader();
+
+	virtual int Start(int boardId, struct BrainFlowInputParams params, bool srb1On);
+
+	virtual void Cancel();
+
+	virtual void RunFunction();
+
+	virtual bool GetIsStreamRunning() { return StreamRunning; }
+
+	virtual bool RequestEnableStreaming(bool enable);
+
+protected:
+
+	virtual std::string ReportSource();
+
+	virtual void Init();
+
+	//  The serial port
+	std::string SerialPortName;
+	int SerialPort;
+
+	bool RequestToggleStreaming;
+	//
+	bool BoardReady() { return SerialPort >= 0; }
+	int InitializeBoard();
+	void InitializeDataReadCounters();
+	void ReleaseBoard();
+	void StartStreaming();
+	void StopStreaming();
+	void WriteCommand(unsigned char command);
+	bool SendCommand(unsigned char command, int responseSize, int timeoutMs);
+
+	//  Run function reading loop
+	ChronoTimer ValidDataTimer;
+	//
+	void EstablishConnectionWithBoard();
+	bool PreparedToReadBoard();
+	void ReadSerialData();
+	void ProcessData(SampleBlock* block);
+
+	//  frame decoding
+	unsigned char ReadBuffer[CONTEC_BUFFERSIZE];
+	int ReadBufferCount;
+	int DiscardedBytes;
+	int FrameCounter;
+	//
+	int DecodeFrames(SampleBlock* block);
+	void DecodeFrame(const unsigned char* frame, SampleBlock* block, int sample);
+
+	//  sample times from the frame count
+	SampleTimeEstimator TimeEstimator;
+	ChronoTimer TimeEstimatorLogTimer;
+	void LogTimeEstimator();
+};
@@ -121,4 +121,11 @@ inline std::string ChannelSetCharacter(int value)
 inline std::string BoolCharacter(bool value)
 {
 	return value ? "1" : "0";
-}
\ No newline at end of file
+}
+
+
+//  Is the command a channel settings command, x (channel) (power down) (gain) (input type) (bias) (srb2) (srb1) X
+inline bool IsChannelSettingsCommand(const std::string& command)
+{
+	return command.size() == 9 && command[0] == 'x' && command[8] == 'X';
+}
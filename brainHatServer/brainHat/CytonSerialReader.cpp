@@ -0,0 +1,813 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <poll.h>
+#include <math.h>
+#include <errno.h>
+#include <chrono>
+
+#include "brainHat.h"
+#include "CytonSerialReader.h"
+#include "BoardDataReader.h"
+#include "StringExtensions.h"
+#include "BoardIds.h"
+#include "SerialPort.h"
+#include "CytonBoardConfiguration.h"
+
+//  serial port wait for data, milliseconds
+#define SERIAL_POLL (20)
+
+//  ADS1299 reference voltage and default gain, and the LIS3DH accelerometer scale
+#define ADS1299_VREF (4.5)
+#define ADS1299_DEFAULTGAIN (24)
+#define LIS3DH_SCALE (0.002 / 16.0)
+
+using namespace std;
+using namespace chrono;
+
+
+//  Cyton Serial Reader, reads packets from the dongle serial port
+//  Construct with callback functions:
+//    -  ConnectionChanged will be called on first discovery of board parameters, then on connect / disconnect state
+//    -  NewSample will be called when new data is read from the board
+//
+CytonSerialReader::CytonSerialReader(ConnectionChangedCallbackFn connectionChangedFn, NewSampleCallbackFn newSampleFn)
+{
+	Init();
+
+	ConnectionChangedCallback = connectionChangedFn;
+	NewSampleCallback = newSampleFn;
+}
+
+
+//  Destructor
+//
+CytonSerialReader::~CytonSerialReader()
+{
+	Cancel();
+}
+
+
+//  Initialize properties
+//
+void CytonSerialReader::Init()
+{
+	SerialPort = -1;
+	BoardOn = true;
+	IsConnected = false;
+	StreamRunning = false;
+	ConnectionChangedCallback = NULL;
+	ConnectionChangedDelegate = NULL;
+	ReadBufferCount = 0;
+	DiscardedBytes = 0;
+	Daisy = false;
+	DaisyFirstHalf = false;
+
+	BoardDataSource::Init();
+	SetExgScale();
+}
+
+
+//  Describe the source of the data
+//
+string CytonSerialReader::ReportSource()
+{
+	return format("Board id %d at %d Hz on %s.", BoardId, SampleRate, SerialPortName.c_str());
+}
+
+
+//  Thread Start
+//
+int CytonSerialReader::Start(int boardId, struct BrainFlowInputParams params, bool srb1On)
+{
+	if (!IsCytonFamily(boardId))
+	{
+		Logging.AddLog("CytonSerialReader", "Start", format("Board %d is not supported by the serial reader.", boardId), LogLevelError);
+		return -1;
+	}
+
+	SerialPortName = params.serial_port;
+	BoardId = boardId;
+	Daisy = boardId == (int)BrainhatBoardIds::CYTON_DAISY_BOARD;
+
+	StartSrb1CytonSet = srb1On;
+	StartSrb1DaisySet = Daisy && srb1On;
+
+	LastSampleIndex = -1;
+
+	Thread::Start();
+
+	return 0;
+}
+
+
+//  Thread Cancel
+//
+void CytonSerialReader::Cancel()
+{
+	Thread::Cancel();
+
+	ReleaseBoard();
+}
+
+
+//  Public function to get current SRB1 state for specified board
+//
+int CytonSerialReader::GetSrb1(int board)
+{
+	if (!BoardSettings.HasValidSettings())
+		return -1;
+
+	if (board == 0 || (Daisy && board == 1 && BoardSettings.Boards.size() > 1))
+		return BoardSettings.Boards[board]->Srb1Set;
+
+	return -1;
+}
+
+
+//  Public function to set SRB1 state
+//
+bool CytonSerialReader::RequestSetSrb1(int board, bool enable)
+{
+	if (!BoardSettings.HasValidSettings() || (int)BoardSettings.Boards.size() <= board || BoardSettings.Boards[board]->Channels.size() < 1)
+	{
+		Logging.AddLog("CytonSerialReader", "RequestSetSrb1", "Invalid parameters for request set SRB1", LogLevelError);
+		return false;
+	}
+
+	//   this is the board configuration index, not the board ID
+	switch (board)
+	{
+	case 0:
+		StartSrb1CytonSet = enable;
+		break;
+	case 1:
+		StartSrb1DaisySet = enable;
+		break;
+	default:
+		return false;
+	}
+
+	auto channelSettings = BoardSettings.Boards[board]->Channels.front();
+	if (CommandsQueueLock.try_lock_for(chrono::milliseconds(1000)))
+	{
+		CommandsQueue.push(FormatSrb1Command(channelSettings, enable));
+
+		CommandsQueueLock.unlock();
+		return true;
+	}
+
+	return false;
+}
+
+
+//  Public function to queue a batch of channel settings commands
+//  the batch is applied together, with one stop of the stream
+//
+bool CytonSerialReader::RequestBoardCommands(const vector<string>& commands)
+{
+	for (auto it = commands.begin(); it != commands.end(); ++it)
+	{
+		if (!IsChannelSettingsCommand(*it))
+		{
+			Logging.AddLog("CytonSerialReader", "RequestBoardCommands", format("Invalid channel settings command %s.", it->c_str()), LogLevelError);
+			return false;
+		}
+	}
+	
+	if (CommandsQueueLock.try_lock_for(chrono::milliseconds(1000)))
+	{
+		for (auto it = commands.begin(); it != commands.end(); ++it)
+			CommandsQueue.push(*it);
+		
+		CommandsQueueLock.unlock();
+		return true;
+	}
+	
+	return false;
+}
+
+
+//  Public funciton to toggle streaming
+//
+bool CytonSerialReader::RequestEnableStreaming(bool enable)
+{
+	if ((enable && !StreamRunning) || (!enable && StreamRunning))
+		RequestToggleStreaming = true;
+
+	return true;
+}
+
+
+//  Initialize Board
+//  opens the serial port, resets the board, reads the channel settings and starts streaming data
+//
+int CytonSerialReader::InitializeBoard()
+{
+	ReleaseBoard();
+	RequestToggleStreaming = false;
+
+	SerialPort = serialOpen(SerialPortName.c_str(), 115200, 1);
+	if (SerialPort < 0)
+	{
+		Logging.AddLog("CytonSerialReader", "InitializeBoard", format("Failed to open serial port %s.", SerialPortName.c_str()), LogLevelDebug);
+		SerialPort = -1;
+		return -1;
+	}
+
+	//  stop any stream left running, and soft reset the board
+	WriteCommand("s");
+	usleep(100 * USLEEP_MILI);
+	serialFlush(SerialPort);
+
+	string response;
+	if (!SendCommand("v", response, 3000))
+	{
+		Logging.AddLog("CytonSerialReader", "InitializeBoard", "Board did not respond to reset.", LogLevelDebug);
+		ReleaseBoard();
+		return -1;
+	}
+
+	if (!LoadBoardRegistersSettings() || !InitializeSrbOnStartup())
+	{
+		Logging.AddLog("CytonSerialReader", "InitializeBoard", "Failed to get board configuration.", LogLevelError);
+		ReleaseBoard();
+		return -1;
+	}
+
+	bool newConnection = SampleRate < 0;
+	if (newConnection)
+	{
+		DataRows = getNumberOfRows(BoardId);
+		SampleRate = getSamplingRate(BoardId);
+
+		ExgChannelCount = getNumberOfExgChannels(BoardId);
+		AccelChannelCount = getNumberOfAccelChannels(BoardId);
+		OtherChannelCount = getNumberOfOtherChannels(BoardId);
+		AnalogChannelCount = getNumberOfAnalogChannels(BoardId);
+
+		ConfigureBlockPool();
+		TimeEstimator.Configure(SampleRate, Daisy ? 2 : 1);
+	}
+
+	ConnectionChanged(newConnection ? New : Connected, BoardId, SampleRate);
+
+	StartStreaming();
+
+	InitializeDataReadCounters();
+
+	ValidDataTimer.Start();
+	IsConnected = true;
+	Logging.AddLog("CytonSerialReader", "InitializeBoard", format("Connected to board %d on %s. Sample rate %d. Reading serial packets.", BoardId, SerialPortName.c_str(), SampleRate), LogLevelInfo);
+
+	return 0;
+}
+
+
+//  Set the state of the SRB1 connected setting on startup initialization
+//
+bool CytonSerialReader::InitializeSrbOnStartup()
+{
+	if (!StartSrb1CytonSet && !StartSrb1DaisySet)
+		return true;
+
+	string response;
+	for (int i = 0; i < 2; i++)
+	{
+		bool set = i == 0 ? StartSrb1CytonSet : StartSrb1DaisySet;
+		if (!set)
+			continue;
+
+		if ((int)BoardSettings.Boards.size() > i)
+		{
+			Logging.AddLog("CytonSerialReader", "InitializeSrbOnStartup", format("Starting %s with SRB1 on.", i == 0 ? "Cyton" : "Daisy"), LogLevelInfo);
+			SendCommand(FormatSrb1Command(BoardSettings.Boards[i]->Channels.front(), true), response, 1000);
+		}
+		else
+		{
+			Logging.AddLog("CytonSerialReader", "InitializeSrbOnStartup", "Unable to set SRB1, invalid board configuration settings.", LogLevelError);
+		}
+	}
+
+	return LoadBoardRegistersSettings();
+}
+
+
+// Initialize the data reading monitor counters
+//
+void CytonSerialReader::InitializeDataReadCounters()
+{
+	LastSampleIndex = -1;
+	LastTimeStampSync = -1;
+	ReadBufferCount = 0;
+	DaisyFirstHalf = false;
+	TimeEstimator.Reset();
+	ResetGapDetection();
+	InspectDataStreamLogTimer.Start();
+	TimeEstimatorLogTimer.Start();
+}
+
+
+//  Release Board
+//  stops the stream and closes the serial port
+//
+void CytonSerialReader::ReleaseBoard()
+{
+	if (SerialPort >= 0)
+	{
+		StopStreaming();
+		serialClose(SerialPort);
+		SerialPort = -1;
+		ConnectionChanged(Disconnected, BoardId, SampleRate);
+	}
+
+	IsConnected = false;
+}
+
+
+//  Start board streaming
+//
+void CytonSerialReader::StartStreaming()
+{
+	if (!StreamRunning && BoardReady())
+	{
+		Logging.AddLog("CytonSerialReader", "StartStreaming", "Starting data stream.", LogLevelInfo);
+		serialFlush(SerialPort);
+		ReadBufferCount = 0;
+		DaisyFirstHalf = false;
+		WriteCommand("b");
+
+		StreamRunning = true;
+		ValidDataTimer.Reset();
+		ConnectionChanged(StreamOn, BoardId, SampleRate);
+	}
+}
+
+
+//  Stop board streaming
+//
+void CytonSerialReader::StopStreaming()
+{
+	if (StreamRunning && BoardReady())
+	{
+		Logging.AddLog("CytonSerialReader", "StopStreaming", "Stopping data stream.", LogLevelInfo);
+		WriteCommand("s");
+		usleep(100 * USLEEP_MILI);
+		serialFlush(SerialPort);
+
+		StreamRunning = false;
+		ConnectionChanged(StreamOff, BoardId, SampleRate);
+	}
+}
+
+
+//  Write a command to the board
+//
+void CytonSerialReader::WriteCommand(string command)
+{
+	if (BoardReady())
+		serialPuts(SerialPort, command.c_str());
+}
+
+
+//  Send a command to the board, with the stream stopped, and read the response up to the end of message marker
+//
+bool CytonSerialReader::SendCommand(string command, string& response, int timeoutMs)
+{
+	response = "";
+	if (!BoardReady())
+		return false;
+
+	WriteCommand(command);
+
+	ChronoTimer timer;
+	timer.Start();
+	while (timer.ElapsedMilliseconds() < timeoutMs)
+	{
+		struct pollfd pfd = { SerialPort, POLLIN, 0 };
+		if (poll(&pfd, 1, SERIAL_POLL) <= 0)
+			continue;
+
+		char buffer[256];
+		int count = read(SerialPort, buffer, sizeof(buffer));
+		if (count < 0)
+			return false;
+
+		response.append(buffer, count);
+		if (response.size() >= 3 && response.compare(response.size() - 3, 3, "$$$") == 0)
+			return true;
+	}
+
+	Logging.AddLog("CytonSerialReader", "SendCommand", format("No response to command %s.", command.c_str()), LogLevelDebug);
+	return false;
+}
+
+
+//  Send a batch of commands, with the stream stopped
+//  up to CYTONSERIAL_COMMANDWINDOW commands are sent ahead of their answers, and each answer lets the next command go,
+//  so the batch takes about one round trip per window instead of one round trip per command
+//  timeoutMs is the longest wait for any one answer
+//
+bool CytonSerialReader::SendCommands(const vector<string>& commands, int timeoutMs)
+{
+	if (!BoardReady())
+		return false;
+
+	int sent = 0;
+	int answered = 0;
+	int total = commands.size();
+	string response;
+
+	ChronoTimer answerTimer;
+	answerTimer.Start();
+	while (answered < total && answerTimer.ElapsedMilliseconds() < timeoutMs)
+	{
+		while (sent < total && sent - answered < CYTONSERIAL_COMMANDWINDOW)
+		{
+			Logging.AddLog("CytonSerialReader", "SendCommands", format("Send to board: %s", commands[sent].c_str()), LogLevelDebug);
+			WriteCommand(commands[sent++]);
+		}
+
+		struct pollfd pfd = { SerialPort, POLLIN, 0 };
+		if (poll(&pfd, 1, SERIAL_POLL) <= 0)
+			continue;
+
+		char buffer[256];
+		int count = read(SerialPort, buffer, sizeof(buffer));
+		if (count < 0)
+			return false;
+
+		response.append(buffer, count);
+
+		//  each answer ends with $$$
+		size_t end;
+		while ((end = response.find("$$$")) != string::npos)
+		{
+			response.erase(0, end + 3);
+			answered++;
+			answerTimer.Reset();
+		}
+	}
+
+	return answered == total;
+}
+
+
+//  Get Board registers string and load board settings
+//
+bool CytonSerialReader::LoadBoardRegistersSettings()
+{
+	Logging.AddLog("CytonSerialReader", "LoadBoardRegistersSettings", "Getting board configuration.", LogLevelDebug);
+
+	int retries = 0;
+	while (retries < 10)
+	{
+		string registersString, version;
+		BoardSettings.ClearBoards();
+		if (SendCommand("?", registersString, 1000) && SendCommand("V", version, 1000))
+		{
+			if (BoardSettings.ReadFromRegisterString("Firmware: " + version + registersString))
+			{
+				SetExgScale();
+				return true;
+			}
+		}
+		retries++;
+	}
+
+	return false;
+}
+
+
+//  Set the scale of each exg channel from the channel gain
+//
+void CytonSerialReader::SetExgScale()
+{
+	static const double gains[] = { 1, 2, 4, 6, 8, 12, 24 };
+
+	int channel = 0;
+	for (auto board = BoardSettings.Boards.begin(); board != BoardSettings.Boards.end(); ++board)
+	{
+		for (auto it = (*board)->Channels.begin(); it != (*board)->Channels.end() && channel < 16; ++it)
+		{
+			int gain = (int)(*it)->Gain;
+			ExgScale[channel++] = ADS1299_VREF / (gain >= 0 && gain <= (int)x24 ? gains[gain] : ADS1299_DEFAULTGAIN) / (pow(2, 23) - 1) * 1000000.0;
+		}
+	}
+
+	while (channel < 16)
+		ExgScale[channel++] = ADS1299_VREF / ADS1299_DEFAULTGAIN / (pow(2, 23) - 1) * 1000000.0;
+}
+
+
+//  Process the commands queue
+//  stops the stream, sends the commands and reloads the board settings
+//
+void CytonSerialReader::ProcessCommandsQueue()
+{
+	CommandsQueueLock.lock();
+
+	auto wasStreaming = StreamRunning;
+	StopStreaming();
+
+	ChronoTimer commandsTimer;
+	commandsTimer.Start();
+
+	int queued = CommandsQueue.size();
+	auto commands = CoalesceBoardCommands(CommandsQueue);
+	if (!SendCommands(commands, 1000))
+	{
+		Logging.AddLog("CytonSerialReader", "ProcessCommandsQueue", "Board did not answer all the commands.", LogLevelError);
+	}
+
+	if (!LoadBoardRegistersSettings())
+	{
+		Logging.AddLog("CytonSerialReader", "ProcessCommandsQueue", "Error restoring board configuration.", LogLevelError);
+	}
+
+	if (wasStreaming)
+	{
+		StartStreaming();
+	}
+
+	Logging.AddLog("CytonSerialReader", "ProcessCommandsQueue", format("Sent %d commands (%d queued) in %d ms.", (int)commands.size(), queued, commandsTimer.ElapsedMilliseconds()), LogLevelInfo);
+
+	CommandsQueueLock.unlock();
+}
+
+
+//  Reconnect to Board
+//
+void CytonSerialReader::EstablishConnectionWithBoard()
+{
+	if (!BoardReady())
+	{
+		if (InitializeBoard() != 0)
+			usleep(3*USLEEP_SEC);
+	}
+}
+
+
+//  Check conditions are OK to read data from the board
+//
+bool CytonSerialReader::PreparedToReadBoard()
+{
+	if (!BoardOn)
+	{
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+
+	//  make sure we are connected to the board
+	EstablishConnectionWithBoard();
+
+	if (!BoardReady())
+	{
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+	else if (RequestToggleStreaming)
+	{
+		if (StreamRunning)
+			StopStreaming();
+		else
+			StartStreaming();
+
+		RequestToggleStreaming = false;
+		return false;
+	}
+	else if (CommandsQueue.size() > 0)
+	{
+		ProcessCommandsQueue();
+		return false;
+	}
+	else if (!StreamRunning)
+	{
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+	else if (ValidDataTimer.ElapsedMilliseconds() > 3000)
+	{
+		//  have not received fresh samples in three seconds, close the port and reinitialize
+		Logging.AddLog("CytonSerialReader", "PreparedToReadBoard", "Too long without valid sample. Reconnecting to board.", LogLevelError);
+		ReconnectStarted(ValidDataTimer.ElapsedMilliseconds());
+		ReleaseBoard();
+		usleep(1*USLEEP_SEC);
+		return false;
+	}
+
+	return true;
+}
+
+
+//  Board reading / control thread run function
+//
+void CytonSerialReader::RunFunction()
+{
+	while (ThreadRunning)
+	{
+		if (!PreparedToReadBoard())
+			continue;
+
+		ReadSerialData();
+	}
+}
+
+
+//  Wait for data on the serial port, read it into the buffer and decode the whole packets
+//
+void CytonSerialReader::ReadSerialData()
+{
+	struct pollfd pfd = { SerialPort, POLLIN, 0 };
+	if (poll(&pfd, 1, SERIAL_POLL) <= 0)
+		return;
+
+	int count = read(SerialPort, ReadBuffer + ReadBufferCount, CYTONSERIAL_BUFFERSIZE - ReadBufferCount);
+	if (count < 0)
+	{
+		Logging.AddLog("CytonSerialReader", "ReadSerialData", format("Failed to read serial port. Error %d.", errno), LogLevelError);
+		ReleaseBoard();
+		return;
+	}
+
+	ReadBufferCount += count;
+	if (ReadBufferCount < CYTONSERIAL_PACKETSIZE)
+		return;
+
+	auto block = BlockPool.Get((ReadBufferCount / CYTONSERIAL_PACKETSIZE) + 1);
+	if (DecodePackets(block) > 0)
+		ProcessData(block);
+	else
+		block->Release();
+}
+
+
+//  Process a block of decoded samples
+//  send to broadcast thread and logging if enabled
+//
+void CytonSerialReader::ProcessData(SampleBlock* block)
+{
+	ValidDataTimer.Reset();
+	ReconnectFinished();
+
+	//  find gaps in the sample index, filling them if enabled
+	block = DetectGaps(block);
+
+	//  sample times from the fit of the sample index to the clock
+	TimeEstimator.AddChunk(block->SampleIndexRow(), block->GetNumberOfSamples(), block->TimeStampRow());
+	LogTimeEstimator();
+
+	ReportGaps(block);
+
+	//  inspect data stream
+	InspectDataStream(block);
+
+	//  publish the block, consumers hold their own references
+	NewSample(block);
+	block->Release();
+}
+
+
+//  Decode the whole packets in the read buffer into the block
+//  a byte that does not start a packet with a valid footer is skipped, so the decoder finds the next packet after noise on the line
+//  the bytes of a partial packet (or the first half of a daisy sample) are kept for the next read
+//
+int CytonSerialReader::DecodePackets(SampleBlock* block)
+{
+	int samples = 0;
+	int position = 0;
+	int pendingHalf = -1;
+
+	while (ReadBufferCount - position >= CYTONSERIAL_PACKETSIZE)
+	{
+		const unsigned char* packet = ReadBuffer + position;
+		if (packet[0] != CYTONSERIAL_STARTBYTE || (packet[CYTONSERIAL_PACKETSIZE - 1] & 0xF0) != CYTONSERIAL_FOOTERBYTE)
+		{
+			position++;
+			DiscardedBytes++;
+			continue;
+		}
+
+		if (!Daisy)
+		{
+			DecodeCytonHalf(packet, block, samples);
+			samples++;
+		}
+		else if (packet[1] % 2 != 0)
+		{
+			//  odd sample numbers are the cyton channels, the sample is complete when the daisy half arrives
+			DecodeCytonHalf(packet, block, samples);
+			DaisyFirstHalf = true;
+			pendingHalf = position;
+		}
+		else if (DaisyFirstHalf)
+		{
+			DecodeDaisyHalf(packet, block, samples);
+			samples++;
+			DaisyFirstHalf = false;
+			pendingHalf = -1;
+		}
+
+		position += CYTONSERIAL_PACKETSIZE;
+	}
+
+	//  keep the cyton half of a daisy sample until the daisy half is read
+	if (pendingHalf >= 0)
+	{
+		position = pendingHalf;
+		DaisyFirstHalf = false;
+	}
+
+	ReadBufferCount -= position;
+	if (ReadBufferCount > 0)
+		memmove(ReadBuffer, ReadBuffer + position, ReadBufferCount);
+
+	block->SetNumberOfSamples(samples);
+	if (samples > 0)
+		memset(block->ValidityRow(), 1, samples);
+
+	return samples;
+}
+
+
+//  Read a signed 24 bit big endian value
+//
+inline int Int24(const unsigned char* bytes)
+{
+	return ((int)(((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) | ((unsigned int)bytes[2] << 8))) >> 8;
+}
+
+
+//  Decode the eight 24 bit exg channels of a packet and scale them to microvolts
+//  the channels are unpacked together and then scaled together, so the compiler can vectorize both loops
+//
+inline void DecodeExg(const unsigned char* exg, const double* scale, double* values)
+{
+	int raw[8];
+	for (int i = 0; i < 8; i++)
+		raw[i] = Int24(exg + (3 * i));
+
+	for (int i = 0; i < 8; i++)
+		values[i] = scale[i] * raw[i];
+}
+
+
+//  Read a signed 16 bit big endian value
+//
+inline int Int16(const unsigned char* bytes)
+{
+	return (int)(short)(((unsigned short)bytes[0] << 8) | bytes[1]);
+}
+
+
+//  Decode a cyton packet, the sample index, the first eight exg channels, the aux data and the footer
+//
+void CytonSerialReader::DecodeCytonHalf(const unsigned char* packet, SampleBlock* block, int sample)
+{
+	const unsigned char* exg = packet + 2;
+	const unsigned char* aux = packet + 26;
+	unsigned char footer = packet[CYTONSERIAL_PACKETSIZE - 1];
+
+	block->SampleIndexRow()[sample] = packet[1];
+
+	double values[8];
+	DecodeExg(exg, ExgScale, values);
+	for (int i = 0; i < 8; i++)
+		block->ExgRow(i)[sample] = values[i];
+
+	for (int i = 0; i < AccelChannelCount && i < 3; i++)
+		block->AccelRow(i)[sample] = footer == CYTONSERIAL_FOOTERBYTE ? LIS3DH_SCALE * Int16(aux + (2 * i)) : 0.0;
+
+	if (OtherChannelCount > 0)
+		block->OtherRow(0)[sample] = footer;
+	for (int i = 1; i < OtherChannelCount && i <= 6; i++)
+		block->OtherRow(i)[sample] = aux[i - 1];
+
+	for (int i = 0; i < AnalogChannelCount && i < 3; i++)
+		block->AnalogRow(i)[sample] = footer == CYTONSERIAL_FOOTERANALOG ? Int16(aux + (2 * i)) : 0.0;
+}
+
+
+//  Decode a daisy packet, the second eight exg channels, the sample index of the combined sample is the cyton sample number, as brainflow reports it
+//
+void CytonSerialReader::DecodeDaisyHalf(const unsigned char* packet, SampleBlock* block, int sample)
+{
+	const unsigned char* exg = packet + 2;
+
+	double values[8];
+	DecodeExg(exg, ExgScale + 8, values);
+	for (int i = 0; i < 8; i++)
+		block->ExgRow(8 + i)[sample] = values[i];
+}
+
+
+//  Log the sample time fit
+//
+void CytonSerialReader::LogTimeEstimator()
+{
+	if (TimeEstimatorLogTimer.ElapsedMilliseconds() < 5000)
+		return;
+
+	TimeEstimatorLogTimer.Reset();
+	Logging.AddLog("CytonSerialReader", "LogTimeEstimator", format("Sample clock drift %.1lf ppm, read jitter %.1lf ms, %d reads in fit, %d anchors, %d bytes discarded.", TimeEstimator.GetDriftPpm(), TimeEstimator.GetResidual() * 1000.0, TimeEstimator.GetWindowSize(), TimeEstimator.GetNumberOfAnchors(), DiscardedBytes), LogLevelTrace);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+#include <queue>
+#include <vector>
+#include <mutex>
+
+#include "BoardDataSource.h"
+#include "SampleBlock.h"
+#include "TimeExtensions.h"
+#include "CytonBoardSettings.h"
+#include "SampleTimeEstimator.h"
+
+//  Cyton serial packet
+#define CYTONSERIAL_PACKETSIZE (33)
+#define CYTONSERIAL_STARTBYTE (0xA0)
+#define CYTONSERIAL_FOOTERBYTE (0xC0)
+#define CYTONSERIAL_FOOTERANALOG (0xC1)
+
+//  number of configuration commands sent ahead of their answers
+#define CYTONSERIAL_COMMANDWINDOW (4)
+
+//  size of the serial read buffer, about a quarter second of packets
+#define CYTONSERIAL_BUFFERSIZE (CYTONSERIAL_PACKETSIZE * 64)
+
+
+//  Cyton Serial Reader
+//  Reads the Cyton (and Cyton + Daisy) dongle serial port directly, without the brainflow board shim
+//
+//  packets are decoded straight into sample blocks from the block pool, with the same rows and scaling as brainflow,
+//  so the rest of the server can not tell the difference between the two readers
+//  there is no brainflow ring buffer and no polling interval, each read of the serial port is decoded and published as it arrives
+//
+class CytonSerialReader : public BoardDataSource
+{
+public:
+	CytonSerialReader(ConnectionChangedCallbackFn connectionChangedFn, NewSampleCallbackFn newSampleFn);
+	virtual ~CytonSerialReader();
+
+	virtual int Start(int boardId, struct BrainFlowInputParams params, bool srb1On);
+
+	virtual void Cancel();
+
+	virtual void RunFunction();
+
+	virtual int GetSrb1(int board);
+	virtual bool GetIsStreamRunning() { return StreamRunning; }
+
+	virtual bool RequestSetSrb1(int board, bool enable);
+	virtual bool RequestEnableStreaming(bool enable);
+	virtual bool RequestBoardCommands(const std::vector<std::string>& commands);
+
+protected:
+
+	virtual std::string ReportSource();
+
+	virtual void Init();
+
+	//  The serial port
+	std::string SerialPortName;
+	int SerialPort;
+
+	bool RequestToggleStreaming;
+	bool StartSrb1CytonSet;
+	bool StartSrb1DaisySet;
+	//
+	bool BoardReady() { return SerialPort >= 0; }
+	int InitializeBoard();
+	bool InitializeSrbOnStartup();
+	void InitializeDataReadCounters();
+	void ReleaseBoard();
+	void StartStreaming();
+	void StopStreaming();
+	bool SendCommand(std::string command, std::string& response, int timeoutMs);
+	bool SendCommands(const std::vector<std::string>& commands, int timeoutMs);
+	void WriteCommand(std::string command);
+
+	//  Run function reading loop
+	ChronoTimer ValidDataTimer;
+	//
+	void EstablishConnectionWithBoard();
+	bool PreparedToReadBoard();
+	void ReadSerialData();
+	void ProcessData(SampleBlock* block);
+
+	//  packet decoding
+	unsigned char ReadBuffer[CYTONSERIAL_BUFFERSIZE];
+	int ReadBufferCount;
+	int DiscardedBytes;
+	bool Daisy;
+	bool DaisyFirstHalf;
+	double ExgScale[16];
+	//
+	void SetExgScale();
+	int DecodePackets(SampleBlock* block);
+	void DecodeCytonHalf(const unsigned char* packet, SampleBlock* block, int sample);
+	void DecodeDaisyHalf(const unsigned char* packet, SampleBlock* block, int sample);
+
+	//  sample times from the sample index
+	SampleTimeEstimator TimeEstimator;
+	ChronoTimer TimeEstimatorLogTimer;
+	void LogTimeEstimator();
+
+	//  Board hardware settings and configuration commands
+	std::timed_mutex CommandsQueueLock;
+	std::queue<std::string> CommandsQueue;
+	void ProcessCommandsQueue();
+	//
+	bool LoadBoardRegistersSettings();
+	CytonBoards BoardSettings;
+};
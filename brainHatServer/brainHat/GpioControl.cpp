@@ -3,6 +3,7 @@
 
 #include "GpioControl.h"
 #include "SimpleTimer.h"
+#include "Thread.h"
 
 using namespace std;
 
@@ -12,18 +13,28 @@ PinController* PinRecordingStatus;
 
 bool Running = false;
 
+//  wakes the timer task when a pin is changed, or to shut down
+ThreadSignal PinsChanged;
+
 // Timer task running to update PIN states
+//  sleeps until the next pin is due to change, or until a pin is changed
 //
 void TimerTask()
 {
 	while (Running)
 	{
-		delay(5);
-	
+		int nextUpdate = -1;
 		for (auto nextPin = Pins.begin(); nextPin != Pins.end(); ++nextPin)
 		{
-			(*nextPin)->Update();
+			int pinUpdate = (*nextPin)->Update();
+			if (pinUpdate >= 0 && (nextUpdate < 0 || pinUpdate < nextUpdate))
+				nextUpdate = pinUpdate;
 		}
+		
+		if (nextUpdate < 0)
+			PinsChanged.Wait();
+		else
+			PinsChanged.WaitFor(nextUpdate);
 	}
 	
 	//  shut down
@@ -68,30 +79,36 @@ void StartGpioController(int pinConnection, int pinRecording)
 void StopGpioController()
 {
 	Running = false;
+	PinsChanged.Notify();
 }
 
 
 void ConnectionLightShowConnecting()
 {
 	PinConnectionStatus->StartFlash(20, 50, 2, 2000);
+	PinsChanged.Notify();
 }
 
 void ConnectionLightShowReady()
 {
 	PinConnectionStatus->StartFlash(1000, 1000, 0, 0);
+	PinsChanged.Notify();
 }
 	
 void ConnectionLightShowConnected()
 {
 	PinConnectionStatus->Switch(true);
+	PinsChanged.Notify();
 }
 
 void ConnectionLightShowPaused()
 {
 	PinConnectionStatus->StartFlash(222, 111, 0, 0);
+	PinsChanged.Notify();
 }
 
 void RecordingLight(bool enable)
 {
 	PinRecordingStatus->Switch(enable);
+	PinsChanged.Notify();
 }
\ No newline at end of file
@@ -81,14 +81,13 @@ string LoggerLog::SerializeAsJson()
 
 //  Constructor
 //
-Logger::Logger()
+Logger::Logger() : CommandQueue(LOGGER_QUEUE_CAPACITY)
 {
 	DisplayOutputEnabled = true;
 	
 	LogLastLevelDisplayed = LogLevelAll;
 	LogDisplayLevel = LogLevelTrace;
-	
-	Notified = false;
+	LoggedDropped = 0;
 }
 
 
@@ -100,6 +99,10 @@ Logger::~Logger()
 	{
 		Cancel();
 	}
+	
+	LoggerLog* log;
+	while (CommandQueue.Pop(log))
+		delete log;
 }
 
 
@@ -109,9 +112,17 @@ void Logger::AddLog(LogEvent log)
 {
 	if (ThreadRunning)
 	{
+		LoggerLog* newLog = new LoggerLog(log);
+		bool added;
+		{
+			LockMutex lockProducer(ProducerMutex);
+			added = CommandQueue.Push(newLog);
+		}
+		
+		if (!added)
 		{
-			LockMutex lockQueue(QueueMutex);
-			CommandQueue.push(new LoggerLog(log));
+			delete newLog;
+			return;
 		}
 	
 		Notify();
@@ -168,6 +179,7 @@ void Logger::ResumeDisplayOutput()
 {
 	DisplayOutputEnabled = true;
 	Display.InitDimensions();
+	Notify();
 }
 
 bool Logger::IsDisplayOutputEnabled()
@@ -196,8 +208,7 @@ void Logger::WriteLineToDisplay(const char* log)
 //
 void Logger::Notify()
 {
-	Notified = true;
-	NotifyQueueCondition.notify_one();
+	RunSignal.Notify();
 }
 
 
@@ -227,74 +238,98 @@ void Logger::RunFunction()
 {
 	Display.InitDimensions();
 	LogLastLevelDisplayed = LogLevelOff;
+	QueueStatsTimer.Start();
 	
 	while (ThreadRunning)
 	{
-		if (CommandQueue.size() == 0  && ThreadRunning)
+		if (QueueStatsTimer.ElapsedMilliseconds() >= LOGGER_STATSMS)
 		{
-			//  wait for messages
-			std::unique_lock<std::mutex> lockNotify(NotifyMutex);
-
-			//  avoid spurious wakeups
-			while(!Notified)
-				NotifyQueueCondition.wait(lockNotify);
+			LogQueueStatistics();
+			QueueStatsTimer.Reset();
+		}
+		
+		if (CommandQueue.IsEmpty()  && ThreadRunning)
+		{
+			//  wait for messages, or the next statistics report
+			RunSignal.WaitFor(LOGGER_STATSMS - QueueStatsTimer.ElapsedMilliseconds());
 
 			//  check to see if we were woken up because of shutdown
 			if(!ThreadRunning)
 				return;
+			continue;
 		}
 		
 		if (!DisplayOutputEnabled)
 		{
-			Sleep(250);
+			//  logs wait in the queue until the display is resumed
+			RunSignal.WaitFor(LOGGER_STATSMS - QueueStatsTimer.ElapsedMilliseconds());
 			continue;
 		}
 		
 
-		//  empty the queue and put the events to send into a list
-		list<LoggerLog*> commands;
+		//  process everything in the queue, a batch at a time
+		LoggerLog* logs[LOGGER_QUEUE_BATCH];
+		int count;
+		while ((count = CommandQueue.PopBatch(logs, LOGGER_QUEUE_BATCH)) > 0)
 		{
-			LockMutex lockQueue(QueueMutex);
-		
-			while (CommandQueue.size() > 0)
+			for (int i = 0; i < count; i++)
 			{
-				commands.push_back(CommandQueue.front());
-				CommandQueue.pop();
+				DisplayLog(logs[i]);
+				delete logs[i];
 			}
 		}
+	}
+}
+
+
+
+
+//  Report logs dropped since the last report
+//  the report goes through the queue like any other log, if there is no room it is made again next time
+//
+void Logger::LogQueueStatistics()
+{
+	unsigned long long dropped = CommandQueue.GetOverflows();
+	if (dropped == LoggedDropped)
+		return;
 	
-		//  process everything in the queue
-		list<LoggerLog*>::iterator nextItem;
-		for (nextItem = commands.begin(); nextItem != commands.end(); ++nextItem)
+	LoggerLog* report = new LoggerLog("Logger", "LogQueueStatistics", format("Log queue full, dropped %llu logs. Max depth %d of %d.", dropped - LoggedDropped, CommandQueue.GetMaxDepth(), CommandQueue.GetCapacity()), LogLevelWarn);
+	bool added;
+	{
+		LockMutex lockProducer(ProducerMutex);
+		added = CommandQueue.Push(report);
+	}
+	
+	if (added)
+		LoggedDropped = dropped;
+	else
+		delete report;
+}
+
+
+//  Print one log to the display, if it is at or above the display level
+//
+void Logger::DisplayLog(LoggerLog* log)
+{
+	if (log->Level >= LogDisplayLevel)
+	{
+		if (LogLastLevelDisplayed != log->Level)
 		{
-			LoggerLog* log = (*nextItem);
-			if (log->Level >= LogDisplayLevel)
-			{
-				if (LogLastLevelDisplayed != log->Level)
-				{
-					LogLastLevelDisplayed = log->Level;
-					Display.SetColour(FgColorForLog(LogLastLevelDisplayed), BgColorForLog(LogLastLevelDisplayed));
-				}
+			LogLastLevelDisplayed = log->Level;
+			Display.SetColour(FgColorForLog(LogLastLevelDisplayed), BgColorForLog(LogLastLevelDisplayed));
+		}
 				
-				tm* logTime = localtime(&(log->Time.tv_sec));
+		tm* logTime = localtime(&(log->Time.tv_sec));
 
-				ostringstream os;		
-				os <<  setfill('0') << setw(2) << logTime->tm_hour << ":" << setw(2) << logTime->tm_min << ":" << setw(2) << logTime->tm_sec <<  "." << std::setw(3) << log->Time.tv_usec / 1000;
-				os << setfill(' ') << "   "  << left << setw(7) << LogLevelString(log->Level) << " " << left << setw(25) << log->Sender << "  " << setw(25) << log->Function << "  " <<  log->Data;			
+		ostringstream os;		
+		os <<  setfill('0') << setw(2) << logTime->tm_hour << ":" << setw(2) << logTime->tm_min << ":" << setw(2) << logTime->tm_sec <<  "." << std::setw(3) << log->Time.tv_usec / 1000;
+		os << setfill(' ') << "   "  << left << setw(7) << LogLevelString(log->Level) << " " << left << setw(25) << log->Sender << "  " << setw(25) << log->Function << "  " <<  log->Data;			
 
-				Display.PrintLine(os.str());
-				
-				delete(*nextItem);
-			}
-		}
-		
-		Notified = false;
+		Display.PrintLine(os.str());
 	}
 }
 
 
-
-
 //  Get string for log level
 //
 string Logger::LogLevelString(LogLevel level)
@@ -2,9 +2,17 @@
 
 #include <string>
 #include <condition_variable>
-#include <queue>
 #include "Thread.h"
+#include "SpscRing.h"
 #include "TerminalDisplay.h"
+#include "TimeExtensions.h"
+
+//  number of logs that can be waiting for the display thread
+#define LOGGER_QUEUE_CAPACITY (4096)
+#define LOGGER_QUEUE_BATCH (64)
+
+//  how often dropped logs are reported
+#define LOGGER_STATSMS (5000)
 
 typedef enum
 {
@@ -77,6 +85,12 @@ public:
 	bool IsDisplayOutputEnabled();
 	
 	void ToggleAppLogLevel(LogLevel level);
+	
+	//  log queue statistics, for the status stream
+	int GetQueueDepth() { return CommandQueue.GetDepth(); }
+	int GetQueueMaxDepth() { return CommandQueue.GetMaxDepth(); }
+	int GetQueueCapacity() { return CommandQueue.GetCapacity(); }
+	unsigned long long GetDroppedLogs() { return CommandQueue.GetOverflows(); }
 		
 	virtual void Start();
 	
@@ -89,17 +103,21 @@ protected:
 	std::string HostName;
 	
 	
-	//  queue lock
-	std::mutex QueueMutex;
-	std::queue<LoggerLog*> CommandQueue;
+	//  log queue, logs come from every thread so producers take turns with the producer lock
+	//  the display thread takes logs without locking
+	std::mutex ProducerMutex;
+	SpscRing<LoggerLog*> CommandQueue;
 	
 	//  queue notification
-	bool Notified;
-	std::condition_variable NotifyQueueCondition;
-	std::mutex NotifyMutex;
-
 	void Notify();
 	
+	//  report logs dropped because the queue was full, from the display thread
+	ChronoTimer QueueStatsTimer;
+	unsigned long long LoggedDropped;
+	void LogQueueStatistics();
+	
+	void DisplayLog(LoggerLog* log);
+	
 	//  display settings
 	TerminalDisplay Display;
 	bool DisplayOutputEnabled;
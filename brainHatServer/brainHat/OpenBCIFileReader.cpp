@@ -0,0 +1,159 @@
+#include <brainflow_constants.h>
+#include "brainHat.h"
+#include "OpenBCIFileReader.h"
+#include "StringExtensions.h"
+#include "Parser.h"
+#include "BoardIds.h"
+
+using namespace std;
+
+
+//  Constructor
+//
+OpenBCIFileReader::OpenBCIFileReader()
+{
+}
+
+
+//  Destructor
+//
+OpenBCIFileReader::~OpenBCIFileReader()
+{
+	Close();
+}
+
+
+//  Open the file and read the header lines
+//
+bool OpenBCIFileReader::Open(string fileName)
+{
+	Close();
+
+	FileName = fileName;
+	File.open(fileName);
+	if (!File.is_open())
+	{
+		Logging.AddLog("OpenBCIFileReader", "Open", format("Unable to open file %s.", fileName.c_str()), LogLevelError);
+		return false;
+	}
+
+	//  read the header, up to the first sample line
+	bool foundData = false;
+	while (!foundData && !File.eof())
+	{
+		auto lineStart = File.tellg();
+		getline(File, Line);
+		if (Line.size() == 0)
+			continue;
+
+		if (Line.substr(0, 1) == "%" || Line.substr(0, 1) == "S")
+		{
+			ReadHeaderLine(Line);
+		}
+		else
+		{
+			DataStart = lineStart;
+			foundData = true;
+		}
+	}
+
+	if (BoardId == (int)BrainhatBoardIds::UNDEFINED || SampleRate <= 0 || !foundData)
+	{
+		Logging.AddLog("OpenBCIFileReader", "Open", format("File %s does not have a valid header or has no samples.", fileName.c_str()), LogLevelError);
+		Close();
+		return false;
+	}
+
+	return Rewind();
+}
+
+
+//  Close the file
+//
+void OpenBCIFileReader::Close()
+{
+	if (File.is_open())
+		File.close();
+}
+
+
+//  Go back to the first sample line
+//
+bool OpenBCIFileReader::Rewind()
+{
+	if (!File.is_open())
+		return false;
+
+	File.clear();
+	File.seekg(DataStart);
+	return File.good();
+}
+
+
+//  Read the next samples
+//
+int OpenBCIFileReader::ReadSamples(SampleBlock* block, int count)
+{
+	if (!File.is_open())
+		return 0;
+
+	int first = block->GetNumberOfSamples();
+	if (first + count > block->GetCapacity())
+		count = block->GetCapacity() - first;
+
+	int read = 0;
+	while (read < count && getline(File, Line))
+	{
+		if (Line.size() == 0 || Line[0] == '%')
+			continue;
+
+		block->SetSampleFromText(first + read, Line);
+		read++;
+	}
+
+	return read;
+}
+
+
+//  Read a header line to setup board parameters
+//
+void OpenBCIFileReader::ReadHeaderLine(string readLine)
+{
+	if (readLine.substr(0, 12) == "%Sample Rate")
+	{
+		auto rateString = readLine.substr(12);
+		Parser parseRate(rateString, " ");
+		auto discard = parseRate.GetNextString();
+		SampleRate = parseRate.GetNextInt();
+	}
+	else if (readLine.substr(0, 19) == "%Number of channels")
+	{
+		auto channelString = readLine.substr(19);
+		Parser parseRate(channelString, " ");
+		auto discard = parseRate.GetNextString();
+		int channels = parseRate.GetNextInt();
+		switch (channels)
+		{
+
+		case 4:
+			BoardId = (int)BoardIds::GANGLION_BOARD;
+			break;
+
+		case 8:
+			BoardId = (int)BoardIds::CYTON_BOARD;
+			break;
+
+		case 16:
+			BoardId = (int)BoardIds::CYTON_DAISY_BOARD;
+			break;
+		default:
+			BoardId = (int)BrainhatBoardIds::UNDEFINED;
+			break;
+		}
+
+		ExgChannelCount = getNumberOfExgChannels(BoardId);
+		AccelChannelCount = getNumberOfAccelChannels(BoardId);
+		OtherChannelCount = getNumberOfOtherChannels(BoardId);
+		AnalogChannelCount = getNumberOfAnalogChannels(BoardId);
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <fstream>
+#include <string>
+
+#include "SampleFileReader.h"
+
+
+//  OpenBCI File Reader
+//  Reads an OpenBCI_GUI format .txt file a block of samples at a time
+//
+//  opening the file only reads the header, the samples are parsed as they are read,
+//  so the file is ready to play at once and memory use does not depend on the length of the file
+//
+class OpenBCIFileReader : public SampleFileReader
+{
+public:
+	OpenBCIFileReader();
+	virtual ~OpenBCIFileReader();
+
+	virtual bool Open(std::string fileName);
+	virtual void Close();
+
+	virtual bool Rewind();
+
+	virtual int ReadSamples(SampleBlock* block, int count);
+
+protected:
+
+	std::ifstream File;
+	std::streampos DataStart;
+
+	//  the line buffer, reused for every line
+	std::string Line;
+
+	void ReadHeaderLine(std::string readLine);
+};
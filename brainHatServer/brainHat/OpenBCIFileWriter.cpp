@@ -3,7 +3,7 @@
 #include "OpenBCIFileWriter.h"
 #include "StringExtensions.h"
 #include "TimeExtensions.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
 #include <iomanip>
 #include "FileExtensions.h"
 #include "BoardIds.h"
@@ -100,49 +100,45 @@ bool OpenBCIFileWriter::OpenFile(string fileName, bool tryUsb)
 //
 void OpenBCIFileWriter::WriteDataToFile()
 {
-	//  empty the queue and put the samples to send into a list
-	list<BFSample*> samples;
-	{
-		LockMutex lockQueue(QueueMutex);
-		
-		while (SamplesQueue.size() > 0)
-		{
-			samples.push_back(SamplesQueue.front());
-			SamplesQueue.pop();
-		}
-	}
+	int count;
 	
-	//  write the data to the file the data
-	for(auto nextSample = samples.begin() ; nextSample != samples.end() ; ++nextSample)
+	//  take the blocks from the queue a batch at a time, and write the data to the file
+	while ((count = TakeBatch()) > 0)
 	{
-		if (!WroteHeader)
+		for (int b = 0; b < count; b++)
 		{
-			WriteHeader(*nextSample);
-		}
+			if (!WroteHeader)
+			{
+				WriteHeader(Batch[b]);
+			}
 		
-		WriteSample(*nextSample);
+			for (int i = 0; i < Batch[b]->GetNumberOfSamples(); i++)
+				WriteSample(Batch[b], i);
 		
-		delete(*nextSample);
+			Batch[b]->Release();
+		}
 	}
 }
 
 
 //  Write the header to the file
 //
-void OpenBCIFileWriter::WriteHeader(BFSample* firstSample)
+void OpenBCIFileWriter::WriteHeader(const SampleBlock* firstBlock)
 {
 	{
 		LockMutex lockFile(RecordingFileMutex);
 		
 		//  metadata header
 		RecordingFile << "%OpenBCI Raw EEG Data" << endl;
-		RecordingFile << "%Number of channels = " << firstSample->GetNumberOfExgChannels() << endl;
+		RecordingFile << "%Number of channels = " << firstBlock->GetNumberOfExgChannels() << endl;
 		RecordingFile << "%Sample Rate = " << SampleRate << " Hz" << endl;
 		RecordingFile << "%Board = " << FileBoardDescription(BoardId) << endl;
 		
 		switch ((BrainhatBoardIds)BoardId)
 		{
 		case BrainhatBoardIds::MENTALIUM:
+		case BrainhatBoardIds::CONTEC:
+		case BrainhatBoardIds::SIGNAL_GENERATOR:
 			RecordingFile << "%ExtraBoardId = " << BoardId << endl;
 			break;
 		}
@@ -151,16 +147,16 @@ void OpenBCIFileWriter::WriteHeader(BFSample* firstSample)
 		//  data header
 		RecordingFile << "Sample Index";
 		
-		for (int i = 0; i < firstSample->GetNumberOfExgChannels(); i++)
+		for (int i = 0; i < firstBlock->GetNumberOfExgChannels(); i++)
 			RecordingFile << ", EXG Channel " << i;
 	
-		for (int i = 0; i < firstSample->GetNumberOfAccelChannels(); i++)
+		for (int i = 0; i < firstBlock->GetNumberOfAccelChannels(); i++)
 			RecordingFile << ", Accel Channel " << i;
 	
-		for (int i = 0; i < firstSample->GetNumberOfOtherChannels(); i++)
+		for (int i = 0; i < firstBlock->GetNumberOfOtherChannels(); i++)
 			RecordingFile << ", Other";
 	
-		for (int i = 0; i < firstSample->GetNumberOfAnalogChannels(); i++)
+		for (int i = 0; i < firstBlock->GetNumberOfAnalogChannels(); i++)
 			RecordingFile << ", Analog Channel " << i;
 	
 		RecordingFile << ", Timestamp, Timestamp (Formatted)" << endl; 
@@ -174,42 +170,42 @@ void OpenBCIFileWriter::WriteHeader(BFSample* firstSample)
 
 //  Write a sample to the file
 //
-void OpenBCIFileWriter::WriteSample(BFSample* sample)
+void OpenBCIFileWriter::WriteSample(const SampleBlock* block, int sample)
 {
 	{
 		LockMutex lockFile(RecordingFileMutex);
 		
 		//  sample index
 		RecordingFile << setprecision(1);
-		RecordingFile << sample->SampleIndex;
+		RecordingFile << block->SampleIndex(sample);
 		
 		//  exg channels
 		RecordingFile << setprecision(6);
-		for (int i = 0; i < sample->GetNumberOfExgChannels(); i++)
-			RecordingFile << "," << sample->GetExg(i);
+		for (int i = 0; i < block->GetNumberOfExgChannels(); i++)
+			RecordingFile << "," << block->GetExg(i, sample);
 		
 		//  accel channels
 		RecordingFile << setprecision(6);
-		for (int i = 0; i < sample->GetNumberOfAccelChannels(); i++)
-			RecordingFile << "," << sample->GetAccel(i);
+		for (int i = 0; i < block->GetNumberOfAccelChannels(); i++)
+			RecordingFile << "," << block->GetAccel(i, sample);
 		
 		//  other channels
 		RecordingFile << setprecision(1);
-		for(int i = 0 ; i < sample->GetNumberOfOtherChannels() ; i++)
-			RecordingFile << "," << sample->GetOther(i);
+		for(int i = 0 ; i < block->GetNumberOfOtherChannels() ; i++)
+			RecordingFile << "," << block->GetOther(i, sample);
 		
 		//  analog channels
 		RecordingFile << setprecision(1);
-		for (int i = 0; i < sample->GetNumberOfAnalogChannels(); i++)
-			RecordingFile << "," << sample->GetAnalog(i);
+		for (int i = 0; i < block->GetNumberOfAnalogChannels(); i++)
+			RecordingFile << "," << block->GetAnalog(i, sample);
 	
 		//  analog channels
 		RecordingFile << setprecision(6);
-		RecordingFile << "," << sample->TimeStamp;
+		RecordingFile << "," << block->TimeStamp(sample);
 		
 		//  local time from time stamp
 		double seconds;
-		double microseconds = modf(sample->TimeStamp, &seconds);
+		double microseconds = modf(block->TimeStamp(sample), &seconds);
 		time_t timeSeconds = (int)seconds;
 		tm* logTime = localtime(&timeSeconds);
 		RecordingFile << "," << setw(4) << logTime->tm_year + 1900 << "-" << setfill('0') << setw(2) << logTime->tm_mon + 1 << "-" << logTime->tm_mday << " " << logTime->tm_hour << ":" <<  logTime->tm_min << ":" <<  logTime->tm_sec <<  "." << setw(4) << (int)(microseconds * 10000);
@@ -5,7 +5,7 @@
 #include <fstream>
 
 #include "Thread.h"
-#include "BFSample.h"
+#include "SampleBlock.h"
 #include "TimeExtensions.h"
 #include "BrainHatFileWriter.h"
 
@@ -25,8 +25,8 @@ protected:
 	virtual void CloseFile();
 	
 	virtual void WriteDataToFile();
-	virtual void WriteHeader(BFSample* firstSample);
-	virtual void WriteSample(BFSample* sample);
+	virtual void WriteHeader(const SampleBlock* firstBlock);
+	virtual void WriteSample(const SampleBlock* block, int sample);
 	
 
 	std::ofstream RecordingFile;
@@ -1,5 +1,6 @@
 #include <string>
 #include <sstream>
+#include <stdlib.h>
 
 #include "Parser.h"
 
@@ -122,4 +123,73 @@ string Parser::GetRemainingBuffer()
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+//  FieldParser
+//  parse numbers from a delimited line without copying
+
+
+//  Constructor
+//
+FieldParser::FieldParser(const char* line, char delimiter)
+{
+	Position = line;
+	Delimiter = delimiter;
+}
+
+
+//  Constructor
+//
+FieldParser::FieldParser(const string& line, char delimiter)
+{
+	Position = line.c_str();
+	Delimiter = delimiter;
+}
+
+
+//  GetNextDouble
+//
+double FieldParser::GetNextDouble()
+{
+	if (AtEnd())
+		return -1;
+
+	char* parsed;
+	double number = strtod(Position, &parsed);
+	bool valid = parsed != Position;
 
+	Position = parsed;
+	SkipField();
+
+	return valid ? number : -1;
+}
+
+
+//  GetNextInt
+//
+int FieldParser::GetNextInt()
+{
+	if (AtEnd())
+		return -1;
+
+	char* parsed;
+	long number = strtol(Position, &parsed, 10);
+	bool valid = parsed != Position;
+
+	Position = parsed;
+	SkipField();
+
+	return valid ? (int)number : -1;
+}
+
+
+//  SkipField
+//  move past the rest of the field and its delimiter
+//
+void FieldParser::SkipField()
+{
+	while (*Position != 0 && *Position != Delimiter)
+		Position++;
+
+	if (*Position == Delimiter)
+		Position++;
+}
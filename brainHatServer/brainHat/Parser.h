@@ -40,4 +40,32 @@ protected:
 };
 
 
+//  Field Parser
+//  reads delimited numbers from a null terminated line in place,
+//  the fields are not copied, so parsing a line does not allocate
+//
+class FieldParser
+{
+public:
+
+	FieldParser(const char* line, char delimiter);
+	FieldParser(const std::string& line, char delimiter);
+
+	//  true when there are no more fields
+	bool AtEnd() const { return *Position == 0; }
+
+	//  returns the next field as a number, or -1 if the field is not a number
+	double GetNextDouble();
+	int GetNextInt();
+
+	//  move past the next field
+	void SkipField();
+
+protected:
+
+	const char* Position;
+	char Delimiter;
+};
+
+
 #endif
\ No newline at end of file
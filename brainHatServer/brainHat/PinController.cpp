@@ -12,6 +12,7 @@ using namespace chrono;
 PinController::PinController(int pinNumber)
 {
 	PinNumber = pinNumber;
+	Mode = PinControlMode::Undefined;
 	if (PinNumber > 0)
 	{
 		pinMode(PinNumber, OUTPUT);
@@ -58,7 +59,7 @@ void PinController::Switch(bool on)
 //  Update, will check blink state and change on the timer interval
 //
 int blinkCounter;
-void PinController::Update()
+int PinController::Update()
 {
 	if (PinNumber > 0)
 	{
@@ -94,10 +95,13 @@ void PinController::Update()
 					}
 				
 					SetTime = timeNow;
+					elapsed = 0;
 				}
+				
+				return BlinkTimeWaiting - elapsed + 1;
 			}
-		
-			break;
 		}
 	}
+	
+	return -1;
 }
\ No newline at end of file
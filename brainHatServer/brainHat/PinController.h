@@ -27,7 +27,8 @@ public:
 	void Switch(bool on);
 	
 	//  Trigger check of flash state, and change of state if necessary
-	void Update();
+	//  returns milliseconds until the next change of state, or -1 if the pin is not flashing
+	int Update();
 	
 protected:
 	
@@ -0,0 +1,239 @@
+#include <string.h>
+#include "json.hpp"
+
+#include "SampleBlock.h"
+#include "StringExtensions.h"
+#include "Parser.h"
+
+using namespace std;
+
+
+//  Sample Block
+//  Construct with the channel counts for the board, and the number of samples to reserve
+//
+SampleBlock::SampleBlock(int exgChannels, int accelChannels, int otherChannels, int analogChannels, int capacity)
+{
+	ExgChannelCount = exgChannels;
+	AccelChannelCount = accelChannels;
+	OtherChannelCount = otherChannels;
+	AnalogChannelCount = analogChannels;
+
+	AccelOffset = 1 + ExgChannelCount;
+	OtherOffset = AccelOffset + AccelChannelCount;
+	AnalogOffset = OtherOffset + OtherChannelCount;
+	Rows = AnalogOffset + AnalogChannelCount + 1;
+
+	Capacity = 0;
+	Samples = 0;
+	Data = NULL;
+	Validity = NULL;
+	Pool = NULL;
+	References = 1;
+
+	Reserve(capacity);
+}
+
+
+//  Destructor
+//
+SampleBlock::~SampleBlock()
+{
+	if (Data != NULL)
+		delete[] Data;
+	if (Validity != NULL)
+		delete[] Validity;
+}
+
+
+//  Add references to the block
+//
+void SampleBlock::AddRef(int count) const
+{
+	References.fetch_add(count, std::memory_order_relaxed);
+}
+
+
+//  Release a reference to the block
+//  the last reference returns the block to its pool
+//
+void SampleBlock::Release() const
+{
+	if (References.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+	
+	SampleBlock* block = const_cast<SampleBlock*>(this);
+	if (Pool != NULL)
+		Pool->Return(block);
+	else
+		delete block;
+}
+
+
+//  Make sure the block can hold capacity samples
+//  the layout is channel major, so growing the block discards the existing data
+//
+void SampleBlock::Reserve(int capacity)
+{
+	if (capacity <= Capacity)
+		return;
+
+	if (Data != NULL)
+		delete[] Data;
+	if (Validity != NULL)
+		delete[] Validity;
+
+	Capacity = capacity;
+	Data = new double[Rows * Capacity];
+	Validity = new unsigned char[Capacity];
+	Samples = 0;
+}
+
+
+//  Set the number of valid samples in the block
+//
+void SampleBlock::SetNumberOfSamples(int samples)
+{
+	if (samples > Capacity)
+		samples = Capacity;
+	else if (samples < 0)
+		samples = 0;
+
+	Samples = samples;
+}
+
+
+//  Fill the block from a brainflow get_board_data chunk
+//  brainflow rows are in the same order as the block rows, so each row is a single copy
+//
+void SampleBlock::InitializeFromChunk(BrainFlowArray<double, 2>& chunk)
+{
+	int samples = chunk.get_size(1);
+	Reserve(samples);
+	if (samples == 0)
+	{
+		Samples = 0;
+		return;
+	}
+
+	const double* raw = chunk.get_raw_ptr();
+	for (int i = 0; i < Rows; i++)
+		memcpy(Row(i), raw + (i * samples), samples * sizeof(double));
+	memset(Validity, 1, samples);
+
+	Samples = samples;
+}
+
+
+//  Set one sample from a single sample object
+//
+void SampleBlock::SetSample(int sample, BFSample* fromSample)
+{
+	if (sample >= Capacity)
+		return;
+
+	SampleIndexRow()[sample] = fromSample->SampleIndex;
+
+	for (int i = 0; i < ExgChannelCount; i++)
+		ExgRow(i)[sample] = fromSample->GetExg(i);
+
+	for (int i = 0; i < AccelChannelCount; i++)
+		AccelRow(i)[sample] = fromSample->GetAccel(i);
+
+	for (int i = 0; i < OtherChannelCount; i++)
+		OtherRow(i)[sample] = fromSample->GetOther(i);
+
+	for (int i = 0; i < AnalogChannelCount; i++)
+		AnalogRow(i)[sample] = fromSample->GetAnalog(i);
+
+	TimeStampRow()[sample] = fromSample->TimeStamp;
+	Validity[sample] = 1;
+
+	if (sample >= Samples)
+		Samples = sample + 1;
+}
+
+
+//  Set one sample from a text line
+//  the line is parsed straight into the rows, without copying the fields
+//
+void SampleBlock::SetSampleFromText(int sample, const string& line)
+{
+	if (sample >= Capacity)
+		return;
+
+	FieldParser parser(line, ',');
+	for (int i = 0; i < Rows; i++)
+		Row(i)[sample] = parser.GetNextDouble();
+
+	Validity[sample] = 1;
+
+	if (sample >= Samples)
+		Samples = sample + 1;
+}
+
+
+//  Append samples from another block with the same layout
+//  returns the number of samples copied, limited by the space left in this block
+//
+int SampleBlock::AppendSamples(const SampleBlock* fromBlock, int fromSample, int count)
+{
+	if (fromBlock->SampleSize() != Rows)
+		return 0;
+
+	if (count > fromBlock->GetNumberOfSamples() - fromSample)
+		count = fromBlock->GetNumberOfSamples() - fromSample;
+	if (count > Capacity - Samples)
+		count = Capacity - Samples;
+	if (count <= 0)
+		return 0;
+
+	for (int i = 0; i < Rows; i++)
+		memcpy(Row(i) + Samples, fromBlock->Row(i) + fromSample, count * sizeof(double));
+	memcpy(Validity + Samples, fromBlock->ValidityRow() + fromSample, count);
+
+	Samples += count;
+	return count;
+}
+
+
+//  Convert one sample to a raw sample
+//
+void SampleBlock::AsRawSample(int sample, double* rawSample) const
+{
+	for (int i = 0; i < Rows; i++)
+		rawSample[i] = Row(i)[sample];
+}
+
+
+//  Convert one sample to json
+//
+void SampleBlock::AsJson(int sample, std::string& json) const
+{
+	nlohmann::json j;
+
+	j["SampleIndex"] = SampleIndex(sample);
+
+	for (int i = 0; i < ExgChannelCount; i++)
+	{
+		j[format("ExgCh%d", i).c_str()] = GetExg(i, sample);
+	}
+
+	for (int i = 0; i < AccelChannelCount; i++)
+	{
+		j[format("AcelCh%d", i).c_str()] = GetAccel(i, sample);
+	}
+
+	for (int i = 0; i < OtherChannelCount; i++)
+	{
+		j[format("Other%d", i).c_str()] = GetOther(i, sample);
+	}
+
+	for (int i = 0; i < AnalogChannelCount; i++)
+	{
+		j[format("AngCh%d", i).c_str()] = GetAnalog(i, sample);
+	}
+
+	j["TimeStamp"] = TimeStamp(sample);
+
+	json = j.dump();
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include "board_shim.h"
+#include "BFSample.h"
+#include "SampleBlockPool.h"
+
+//  Sample Block
+//  A block of samples stored in one contiguous, channel-major allocation
+//  typically holds one whole chunk read from the board
+//
+//  Rows are:
+//		- Sample Index
+//		- EXG Channels
+//		- Accelerometer Channels
+//		- Other Channels
+//		- Analog Channels
+//		- Time Stamp
+//  each row holds Capacity values, so all the samples for one channel are adjacent in memory
+//  alongside the rows, each sample has a validity flag, 1 for a sample read from the board, 0 for a sample filled in for a gap
+//
+//  Blocks are reference counted, a new block has one reference for the data source that fills it
+//  once published, the block is not changed, and every consumer holding it calls AddRef() and Release()
+//  the last Release() returns the block to its pool (or deletes it if it has no pool)
+//
+class SampleBlock
+{
+	friend class SampleBlockPool;
+	
+public:
+
+	SampleBlock(int exgChannels, int accelChannels, int otherChannels, int analogChannels, int capacity);
+	virtual ~SampleBlock();
+
+	//  Reference counting
+	void AddRef(int count = 1) const;
+	void Release() const;
+
+	//  layout
+	int GetNumberOfExgChannels() const { return ExgChannelCount; }
+	int GetNumberOfAccelChannels() const { return AccelChannelCount; }
+	int GetNumberOfOtherChannels() const { return OtherChannelCount; }
+	int GetNumberOfAnalogChannels() const { return AnalogChannelCount; }
+
+	//  number of rows, same as BFSample::SampleSize()
+	int SampleSize() const { return Rows; }
+
+	int GetCapacity() const { return Capacity; }
+	int GetNumberOfSamples() const { return Samples; }
+	
+	//  make sure the block can hold capacity samples, growing the block discards the data in it
+	void Reserve(int capacity);
+
+	void SetNumberOfSamples(int samples);
+
+	//  row access, each row is GetNumberOfSamples() values long
+	double* Row(int row) { return Data + (row * Capacity); }
+	const double* Row(int row) const { return Data + (row * Capacity); }
+	//
+	double* SampleIndexRow() { return Row(0); }
+	const double* SampleIndexRow() const { return Row(0); }
+	double* ExgRow(int channel) { return Row(1 + channel); }
+	const double* ExgRow(int channel) const { return Row(1 + channel); }
+	double* AccelRow(int channel) { return Row(AccelOffset + channel); }
+	const double* AccelRow(int channel) const { return Row(AccelOffset + channel); }
+	double* OtherRow(int channel) { return Row(OtherOffset + channel); }
+	const double* OtherRow(int channel) const { return Row(OtherOffset + channel); }
+	double* AnalogRow(int channel) { return Row(AnalogOffset + channel); }
+	const double* AnalogRow(int channel) const { return Row(AnalogOffset + channel); }
+	double* TimeStampRow() { return Row(Rows - 1); }
+	const double* TimeStampRow() const { return Row(Rows - 1); }
+	unsigned char* ValidityRow() { return Validity; }
+	const unsigned char* ValidityRow() const { return Validity; }
+
+	//  single value access
+	double SampleIndex(int sample) const { return SampleIndexRow()[sample]; }
+	double TimeStamp(int sample) const { return TimeStampRow()[sample]; }
+	double GetExg(int channel, int sample) const { return ExgRow(channel)[sample]; }
+	double GetAccel(int channel, int sample) const { return AccelRow(channel)[sample]; }
+	double GetOther(int channel, int sample) const { return OtherRow(channel)[sample]; }
+	double GetAnalog(int channel, int sample) const { return AnalogRow(channel)[sample]; }
+	bool IsValid(int sample) const { return Validity[sample] != 0; }
+
+	//  fill the block from a brainflow get_board_data chunk
+	void InitializeFromChunk(BrainFlowArray<double, 2>& chunk);
+
+	//  set one sample from a single sample object
+	void SetSample(int sample, BFSample* fromSample);
+
+	//  set one sample from a comma separated text line, the fields in row order (index, exg, accel, other, analog, time stamp)
+	void SetSampleFromText(int sample, const std::string& line);
+
+	//  copy count samples from another block with the same layout, returns number of samples copied
+	int AppendSamples(const SampleBlock* fromBlock, int fromSample, int count);
+
+	//  convert one sample to a raw sample (SampleSize() values)
+	void AsRawSample(int sample, double* rawSample) const;
+
+	//  convert one sample to json
+	void AsJson(int sample, std::string& json) const;
+
+protected:
+
+	int ExgChannelCount;
+	int AccelChannelCount;
+	int OtherChannelCount;
+	int AnalogChannelCount;
+
+	int AccelOffset;
+	int OtherOffset;
+	int AnalogOffset;
+	int Rows;
+
+	int Capacity;
+	int Samples;
+	double* Data;
+	unsigned char* Validity;
+
+	SampleBlockPool* Pool;
+	mutable std::atomic<int> References;
+};
@@ -0,0 +1,150 @@
+#include "SampleBlockPool.h"
+#include "SampleBlock.h"
+#include "Thread.h"
+
+using namespace std;
+
+
+//  Sample Block Pool
+//  Not usable until Configure() is called with the board layout
+//
+SampleBlockPool::SampleBlockPool()
+{
+	ExgChannelCount = 0;
+	AccelChannelCount = 0;
+	OtherChannelCount = 0;
+	AnalogChannelCount = 0;
+	BlockCapacity = 0;
+	PoolSize = 0;
+
+	Hits = 0;
+	Misses = 0;
+	Outstanding = 0;
+	HighWaterMark = 0;
+}
+
+
+//  Destructor
+//
+SampleBlockPool::~SampleBlockPool()
+{
+	LockMutex lockPool(PoolMutex);
+	ClearFreeBlocks();
+}
+
+
+//  Set the board layout and fill the free list
+//  blocks from a previous layout that are still in use will be deleted when they are released
+//
+void SampleBlockPool::Configure(int exgChannels, int accelChannels, int otherChannels, int analogChannels, int blockCapacity, int poolSize)
+{
+	LockMutex lockPool(PoolMutex);
+
+	ClearFreeBlocks();
+
+	ExgChannelCount = exgChannels;
+	AccelChannelCount = accelChannels;
+	OtherChannelCount = otherChannels;
+	AnalogChannelCount = analogChannels;
+	BlockCapacity = blockCapacity;
+	PoolSize = poolSize;
+
+	Hits = 0;
+	Misses = 0;
+	HighWaterMark = Outstanding;
+
+	FreeBlocks.reserve(PoolSize);
+	for (int i = 0; i < PoolSize; i++)
+	{
+		auto block = new SampleBlock(ExgChannelCount, AccelChannelCount, OtherChannelCount, AnalogChannelCount, BlockCapacity);
+		block->Pool = this;
+		FreeBlocks.push_back(block);
+	}
+}
+
+
+//  Get a block with room for at least samples
+//  if the free list is empty, a new block is created, and it will join the free list when released
+//
+SampleBlock* SampleBlockPool::Get(int samples)
+{
+	SampleBlock* block = NULL;
+	{
+		LockMutex lockPool(PoolMutex);
+
+		if (FreeBlocks.size() > 0)
+		{
+			block = FreeBlocks.back();
+			FreeBlocks.pop_back();
+			Hits++;
+		}
+		else
+		{
+			Misses++;
+		}
+
+		Outstanding++;
+		if (Outstanding > HighWaterMark)
+			HighWaterMark = Outstanding;
+	}
+
+	if (block == NULL)
+	{
+		block = new SampleBlock(ExgChannelCount, AccelChannelCount, OtherChannelCount, AnalogChannelCount, samples > BlockCapacity ? samples : BlockCapacity);
+		block->Pool = this;
+	}
+	else
+	{
+		block->Reserve(samples);
+	}
+
+	block->SetNumberOfSamples(0);
+	block->References = 1;
+	return block;
+}
+
+
+//  Return a block to the free list
+//  blocks that do not fit the pool layout, or do not fit in the free list, are deleted
+//
+void SampleBlockPool::Return(SampleBlock* block)
+{
+	{
+		LockMutex lockPool(PoolMutex);
+
+		Outstanding--;
+
+		if (MatchesLayout(block) && (int)FreeBlocks.size() < PoolSize)
+		{
+			FreeBlocks.push_back(block);
+			return;
+		}
+	}
+
+	block->Pool = NULL;
+	delete block;
+}
+
+
+//  Check that the block has the current pool layout
+//
+bool SampleBlockPool::MatchesLayout(SampleBlock* block)
+{
+	return block->GetNumberOfExgChannels() == ExgChannelCount &&
+		block->GetNumberOfAccelChannels() == AccelChannelCount &&
+		block->GetNumberOfOtherChannels() == OtherChannelCount &&
+		block->GetNumberOfAnalogChannels() == AnalogChannelCount;
+}
+
+
+//  Delete the blocks in the free list, call with the pool locked
+//
+void SampleBlockPool::ClearFreeBlocks()
+{
+	for (auto it = FreeBlocks.begin(); it != FreeBlocks.end(); ++it)
+	{
+		(*it)->Pool = NULL;
+		delete *it;
+	}
+	FreeBlocks.clear();
+}
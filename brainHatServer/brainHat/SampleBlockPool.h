@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <mutex>
+
+class SampleBlock;
+
+
+//  Sample Block Pool
+//  Fixed capacity, thread safe free list of sample blocks for one board layout
+//  blocks are created up front when the board layout is known, and released blocks go back on the free list
+//  so the steady state data path does no heap allocation
+//
+class SampleBlockPool
+{
+public:
+	SampleBlockPool();
+	virtual ~SampleBlockPool();
+
+	//  Set the board layout, and create the free blocks
+	void Configure(int exgChannels, int accelChannels, int otherChannels, int analogChannels, int blockCapacity, int poolSize);
+
+	bool IsConfigured() { return PoolSize > 0; }
+
+	//  Get a block with room for at least samples, from the free list if possible
+	SampleBlock* Get(int samples);
+
+	//  Return a block to the free list, called from SampleBlock::Release() when the last reference is released
+	void Return(SampleBlock* block);
+
+	//  Statistics
+	int GetHits() { return Hits; }
+	int GetMisses() { return Misses; }
+	int GetOutstanding() { return Outstanding; }
+	int GetHighWaterMark() { return HighWaterMark; }
+	int GetPoolSize() { return PoolSize; }
+	int GetBlockCapacity() { return BlockCapacity; }
+
+protected:
+
+	std::mutex PoolMutex;
+	std::vector<SampleBlock*> FreeBlocks;
+
+	int ExgChannelCount;
+	int AccelChannelCount;
+	int OtherChannelCount;
+	int AnalogChannelCount;
+	int BlockCapacity;
+	int PoolSize;
+
+	int Hits;
+	int Misses;
+	int Outstanding;
+	int HighWaterMark;
+
+	bool MatchesLayout(SampleBlock* block);
+	void ClearFreeBlocks();
+};
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include "SampleBus.h"
+#include "StringExtensions.h"
+#include "Thread.h"
+#include "brainHat.h"
+
+using namespace std;
+
+
+//  Overflow policy names
+//
+string SampleBusOverflowPolicyName(SampleBusOverflowPolicy policy)
+{
+	switch (policy)
+	{
+	case OverflowBlock:
+		return "block";
+	case OverflowDropOldest:
+		return "dropoldest";
+	case OverflowDropNewest:
+		return "dropnewest";
+	case OverflowDecimate:
+		return "decimate";
+	default:
+		return "unknown";
+	}
+}
+
+
+//  Parse an overflow policy name
+//
+bool ParseSampleBusOverflowPolicy(string name, SampleBusOverflowPolicy& policy)
+{
+	for (int i = OverflowBlock; i <= OverflowDecimate; i++)
+	{
+		if (name == SampleBusOverflowPolicyName((SampleBusOverflowPolicy)i))
+		{
+			policy = (SampleBusOverflowPolicy)i;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+
+//  Sample Bus Subscriber
+//
+
+//  Constructor
+//
+SampleBusSubscriber::SampleBusSubscriber(string name, int queueCapacity, int batchSize, SampleBusOverflowPolicy policy) : SamplesQueue(queueCapacity)
+{
+	SubscriberName = name;
+	BatchSize = batchSize;
+	OverflowPolicy = policy;
+	
+	DecimateCounter = 0;
+	DroppedNewest = 0;
+	DroppedOldest = 0;
+	Decimated = 0;
+	BlockTimeouts = 0;
+	LoggedDropped = 0;
+	Wakeups = 0;
+	WakeupRate = 0.0;
+
+	Batch.resize(BatchSize);
+}
+
+
+//  Destructor
+//  the subscriber must be unsubscribed before it is destroyed
+//
+SampleBusSubscriber::~SampleBusSubscriber()
+{
+	ClearQueue();
+}
+
+
+//  Set the queue capacity and policy
+//
+void SampleBusSubscriber::ConfigureQueue(int queueCapacity, SampleBusOverflowPolicy policy)
+{
+	ClearQueue();
+	SamplesQueue.Resize(queueCapacity);
+	OverflowPolicy = policy;
+	
+	DecimateCounter = 0;
+	DroppedNewest = 0;
+	DroppedOldest = 0;
+	Decimated = 0;
+	BlockTimeouts = 0;
+	LoggedDropped = 0;
+}
+
+
+//  Deliver a block to the queue, applying the overflow policy
+//  the block has a reference for this subscriber, which is released here if the block is dropped
+//
+void SampleBusSubscriber::Deliver(const SampleBlock* block)
+{
+	switch (OverflowPolicy)
+	{
+	case OverflowBlock:
+		{
+			//  wait for the consumer to make room, but never forever
+			auto deadline = chrono::steady_clock::now() + chrono::milliseconds(SAMPLEQUEUE_BLOCKTIMEOUTMS);
+			while (SamplesQueue.IsFull() && chrono::steady_clock::now() < deadline)
+			{
+				SpaceAvailable.WaitUntil(deadline);
+			}
+			
+			if (!SamplesQueue.Push(block))
+			{
+				BlockTimeouts++;
+				block->Release();
+				return;
+			}
+		}
+		break;
+		
+	case OverflowDropOldest:
+		{
+			const SampleBlock* oldest;
+			if (SamplesQueue.IsFull() && SamplesQueue.DropOldest(oldest))
+			{
+				DroppedOldest++;
+				oldest->Release();
+			}
+			
+			if (!SamplesQueue.Push(block))
+			{
+				DroppedNewest++;
+				block->Release();
+				return;
+			}
+		}
+		break;
+		
+	case OverflowDecimate:
+		{
+			if (SamplesQueue.GetDepth() >= SamplesQueue.GetCapacity() / 2)
+			{
+				//  behind, keep every other block
+				if ((DecimateCounter++ % 2) != 0)
+				{
+					Decimated++;
+					block->Release();
+					return;
+				}
+			}
+			else
+			{
+				DecimateCounter = 0;
+			}
+			
+			if (!SamplesQueue.Push(block))
+			{
+				DroppedNewest++;
+				block->Release();
+				return;
+			}
+		}
+		break;
+		
+	default:
+		{
+			if (!SamplesQueue.Push(block))
+			{
+				DroppedNewest++;
+				block->Release();
+				return;
+			}
+		}
+		break;
+	}
+
+	DataQueued();
+}
+
+
+//  Take the next batch of blocks from the queue
+//
+int SampleBusSubscriber::TakeBatch()
+{
+	int count = SamplesQueue.PopBatch(Batch.data(), BatchSize);
+	
+	if (count > 0 && OverflowPolicy == OverflowBlock)
+		SpaceAvailable.Notify();
+	
+	return count;
+}
+
+
+//  Release everything left in the queue
+//  call from the consumer thread, or when the consumer thread is stopped
+//
+void SampleBusSubscriber::ClearQueue()
+{
+	const SampleBlock* block;
+	while (SamplesQueue.Pop(block))
+		block->Release();
+}
+
+
+//  Get the queue status
+//
+SampleBusSubscriberStatus SampleBusSubscriber::GetStatus()
+{
+	SampleBusSubscriberStatus status;
+	
+	status.Name = SubscriberName;
+	status.Policy = SampleBusOverflowPolicyName(OverflowPolicy);
+	status.Capacity = SamplesQueue.GetCapacity();
+	status.Depth = SamplesQueue.GetDepth();
+	status.MaxDepth = SamplesQueue.GetMaxDepth();
+	status.DroppedNewest = DroppedNewest;
+	status.DroppedOldest = DroppedOldest;
+	status.Decimated = Decimated;
+	status.BlockTimeouts = BlockTimeouts;
+	status.Wakeups = Wakeups;
+	status.WakeupRate = WakeupRate;
+	
+	return status;
+}
+
+
+//  Log the queue statistics
+//
+void SampleBusSubscriber::LogQueueStatistics(unsigned long long wakeups, double seconds)
+{
+	if (seconds > 0.0)
+		WakeupRate = (wakeups - Wakeups) / seconds;
+	Wakeups = wakeups;
+
+	Logging.AddLog(SubscriberName, "LogQueueStatistics", format("Queue depth %d max %d of %d, %s, %.1lf wakeups per second.", SamplesQueue.GetDepth(), SamplesQueue.GetMaxDepth(), SamplesQueue.GetCapacity(), SampleBusOverflowPolicyName(OverflowPolicy).c_str(), (double)WakeupRate), LogLevelTrace);
+
+	unsigned long long dropped = GetQueueDropped();
+	if (dropped != LoggedDropped)
+	{
+		Logging.AddLog(SubscriberName, "LogQueueStatistics", format("Queue full, dropped %llu blocks. Newest %llu oldest %llu decimated %llu block timeouts %llu.", dropped - LoggedDropped, (unsigned long long)DroppedNewest, (unsigned long long)DroppedOldest, (unsigned long long)Decimated, (unsigned long long)BlockTimeouts), LogLevelWarn);
+		LoggedDropped = dropped;
+	}
+}
+
+
+
+//  Sample Bus
+//
+
+//  Constructor
+//
+SampleBus::SampleBus()
+{
+}
+
+
+//  Destructor
+//
+SampleBus::~SampleBus()
+{
+}
+
+
+//  Add a subscriber
+//
+void SampleBus::Subscribe(SampleBusSubscriber* subscriber)
+{
+	LockMutex lockSubscribers(SubscribersMutex);
+
+	if (find(Subscribers.begin(), Subscribers.end(), subscriber) == Subscribers.end())
+	{
+		Subscribers.push_back(subscriber);
+	}
+}
+
+
+//  Remove a subscriber
+//  waits for any publish in progress to finish, so the bus will not deliver to it again
+//
+void SampleBus::Unsubscribe(SampleBusSubscriber* subscriber)
+{
+	{
+		LockMutex lockSubscribers(SubscribersMutex);
+
+		auto it = find(Subscribers.begin(), Subscribers.end(), subscriber);
+		if (it != Subscribers.end())
+			Subscribers.erase(it);
+	}
+
+	LockMutex lockPublish(PublishMutex);
+}
+
+
+//  Publish a block to the subscribers
+//  takes all the references for the subscribers in one step, the publisher keeps its own reference
+//  the receivers are copied so the subscribers lock is not held while delivering,
+//  and subscribers with the block policy are delivered to last, so waiting for one does not hold up the others
+//
+void SampleBus::Publish(const SampleBlock* block)
+{
+	LockMutex lockPublish(PublishMutex);
+
+	Receivers.clear();
+	{
+		LockMutex lockSubscribers(SubscribersMutex);
+
+		Receivers.reserve(Subscribers.size());
+		for (auto it = Subscribers.begin(); it != Subscribers.end(); ++it)
+		{
+			if ((*it)->OverflowPolicy != OverflowBlock && (*it)->AcceptsData())
+				Receivers.push_back(*it);
+		}
+		for (auto it = Subscribers.begin(); it != Subscribers.end(); ++it)
+		{
+			if ((*it)->OverflowPolicy == OverflowBlock && (*it)->AcceptsData())
+				Receivers.push_back(*it);
+		}
+	}
+
+	if (Receivers.size() == 0)
+		return;
+
+	block->AddRef(Receivers.size());
+	for (auto it = Receivers.begin(); it != Receivers.end(); ++it)
+	{
+		(*it)->Deliver(block);
+	}
+}
+
+
+//  Number of subscribers
+//
+int SampleBus::GetNumberOfSubscribers()
+{
+	LockMutex lockSubscribers(SubscribersMutex);
+	return Subscribers.size();
+}
+
+
+//  Queue status of each subscriber
+//
+vector<SampleBusSubscriberStatus> SampleBus::GetStatus()
+{
+	LockMutex lockSubscribers(SubscribersMutex);
+	
+	vector<SampleBusSubscriberStatus> status;
+	for (auto it = Subscribers.begin(); it != Subscribers.end(); ++it)
+	{
+		status.push_back((*it)->GetStatus());
+	}
+	
+	return status;
+}
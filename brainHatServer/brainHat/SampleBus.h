@@ -0,0 +1,181 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include "SampleBlock.h"
+#include "SpscRing.h"
+#include "Thread.h"
+#include "json.hpp"
+
+//  default subscriber queue capacity, and number of blocks taken per batch
+#define SAMPLEQUEUE_CAPACITY (2048)
+#define SAMPLEQUEUE_BATCH (64)
+
+//  longest time the publisher will wait for room in a queue with the Block policy, before dropping the block
+#define SAMPLEQUEUE_BLOCKTIMEOUTMS (1000)
+
+
+//  Overflow policy for a subscriber queue, what happens to a new block when the queue is full
+//
+typedef enum
+{
+	OverflowBlock,		//  the publisher waits for room in the queue (up to the block timeout, then the new block is dropped)
+	OverflowDropOldest,	//  the oldest block in the queue is dropped to make room
+	OverflowDropNewest,	//  the new block is not queued
+	OverflowDecimate,	//  once the queue is half full only every other block is queued, when full the new block is not queued
+} SampleBusOverflowPolicy;
+
+//  policy names for command line arguments and status
+std::string SampleBusOverflowPolicyName(SampleBusOverflowPolicy policy);
+bool ParseSampleBusOverflowPolicy(std::string name, SampleBusOverflowPolicy& policy);
+
+
+//  Status of a subscriber queue, for the bhStatus stream
+//
+struct SampleBusSubscriberStatus
+{
+	std::string Name;
+	std::string Policy;
+	int Capacity;
+	int Depth;
+	int MaxDepth;
+	unsigned long long DroppedNewest;
+	unsigned long long DroppedOldest;
+	unsigned long long Decimated;
+	unsigned long long BlockTimeouts;
+	unsigned long long Wakeups;
+	double WakeupRate;
+
+	nlohmann::json AsJson()
+	{
+		nlohmann::json j;
+
+		j["Name"] = Name;
+		j["Policy"] = Policy;
+		j["Capacity"] = Capacity;
+		j["Depth"] = Depth;
+		j["MaxDepth"] = MaxDepth;
+		j["DroppedNewest"] = DroppedNewest;
+		j["DroppedOldest"] = DroppedOldest;
+		j["Decimated"] = Decimated;
+		j["BlockTimeouts"] = BlockTimeouts;
+		j["Wakeups"] = Wakeups;
+		j["WakeupRate"] = WakeupRate;
+
+		return j;
+	}
+};
+
+
+//  Sample Bus Subscriber
+//  Base class for a component that takes sample blocks from the bus
+//  each subscriber has its own bounded queue, and takes blocks from it in batches on its own thread
+//
+class SampleBusSubscriber
+{
+	friend class SampleBus;
+
+public:
+	SampleBusSubscriber(std::string name, int queueCapacity, int batchSize, SampleBusOverflowPolicy policy);
+	virtual ~SampleBusSubscriber();
+
+	std::string GetSubscriberName() { return SubscriberName; }
+
+	//  set the queue capacity (in blocks) and the overflow policy
+	//  only call before subscribing, with the consumer thread stopped
+	void ConfigureQueue(int queueCapacity, SampleBusOverflowPolicy policy);
+
+	//  release everything still in the queue
+	//  call from the consumer thread, or once the consumer thread is stopped and the subscriber is unsubscribed
+	void ClearQueue();
+
+	//  queue statistics
+	int GetQueueDepth() { return SamplesQueue.GetDepth(); }
+	int GetQueueMaxDepth() { return SamplesQueue.GetMaxDepth(); }
+	int GetQueueCapacity() { return SamplesQueue.GetCapacity(); }
+	unsigned long long GetQueueDropped() { return DroppedNewest + DroppedOldest + Decimated + BlockTimeouts; }
+	SampleBusSubscriberStatus GetStatus();
+
+protected:
+
+	//  return false to skip publishing to this subscriber, called in the publishing thread
+	virtual bool AcceptsData() { return true; }
+
+	//  called in the publishing thread after a block was queued, wake up the consumer
+	virtual void DataQueued() = 0;
+
+	//  take the next batch of blocks from the queue into Batch, returns the number taken
+	//  the subscriber owns one reference to each block taken, and must Release() it
+	//  call from the consumer thread only
+	int TakeBatch();
+	std::vector<const SampleBlock*> Batch;
+
+	//  log the queue statistics, and warn if blocks were dropped since the last time
+	//  wakeups is the count of the consumer thread, seconds is the time since the last call, for the wakeup rate
+	void LogQueueStatistics(unsigned long long wakeups, double seconds);
+
+	std::string SubscriberName;
+	int BatchSize;
+	SampleBusOverflowPolicy OverflowPolicy;
+
+private:
+
+	//  called by the bus in the publishing thread, the block already has a reference for this subscriber
+	void Deliver(const SampleBlock* block);
+
+	SpscRing<const SampleBlock*> SamplesQueue;
+	
+	//  wakes a publisher waiting for room with the Block policy
+	ThreadSignal SpaceAvailable;
+	
+	//  Decimate policy, count of blocks offered while decimating
+	int DecimateCounter;
+
+	//  drop counters by policy
+	std::atomic<unsigned long long> DroppedNewest;
+	std::atomic<unsigned long long> DroppedOldest;
+	std::atomic<unsigned long long> Decimated;
+	std::atomic<unsigned long long> BlockTimeouts;
+	unsigned long long LoggedDropped;
+
+	//  consumer thread wakeups, and the rate over the last statistics interval
+	std::atomic<unsigned long long> Wakeups;
+	std::atomic<double> WakeupRate;
+};
+
+
+
+//  Sample Bus
+//  Distributes sample blocks from the data source to any number of subscribers
+//  the data source publishes each block once, subscribers get a shared reference to it, the data is never copied
+//  Publish() must always be called from the same thread
+//
+class SampleBus
+{
+public:
+	SampleBus();
+	virtual ~SampleBus();
+
+	//  add or remove a subscriber, once Unsubscribe() returns the bus will not deliver to it again
+	void Subscribe(SampleBusSubscriber* subscriber);
+	void Unsubscribe(SampleBusSubscriber* subscriber);
+
+	//  publish a block to all of the subscribers
+	void Publish(const SampleBlock* block);
+
+	int GetNumberOfSubscribers();
+
+	//  queue status of each subscriber
+	std::vector<SampleBusSubscriberStatus> GetStatus();
+
+protected:
+
+	std::mutex SubscribersMutex;
+	std::vector<SampleBusSubscriber*> Subscribers;
+
+	//  held while a block is delivered, so Unsubscribe() can wait for a publish in progress
+	std::mutex PublishMutex;
+
+	//  subscribers accepting the block being published, copied from the subscribers under the lock
+	std::vector<SampleBusSubscriber*> Receivers;
+};
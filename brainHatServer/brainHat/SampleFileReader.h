@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+
+#include "SampleBlock.h"
+#include "BoardIds.h"
+
+
+//  Sample File Reader
+//  Base class for the recording formats the file simulator can play back
+//
+//  a reader opens the file and reads the board properties from the header,
+//  then reads the samples a block at a time, so memory use does not depend on the length of the file
+//
+class SampleFileReader
+{
+public:
+	SampleFileReader()
+	{
+		BoardId = (int)BrainhatBoardIds::UNDEFINED;
+		SampleRate = -1;
+		ExgChannelCount = 0;
+		AccelChannelCount = 0;
+		OtherChannelCount = 0;
+		AnalogChannelCount = 0;
+	}
+	virtual ~SampleFileReader() {}
+
+	//  open the file and read the header, leaves the file at the first sample
+	virtual bool Open(std::string fileName) = 0;
+	virtual void Close() = 0;
+
+	//  go back to the first sample
+	virtual bool Rewind() = 0;
+
+	//  read up to count samples into the end of the block, returns the number read, zero at the end of the file
+	virtual int ReadSamples(SampleBlock* block, int count) = 0;
+
+	std::string GetFileName() { return FileName; }
+	int GetBoardId() { return BoardId; }
+	int GetSampleRate() { return SampleRate; }
+	int GetNumberOfExgChannels() { return ExgChannelCount; }
+	int GetNumberOfAccelChannels() { return AccelChannelCount; }
+	int GetNumberOfOtherChannels() { return OtherChannelCount; }
+	int GetNumberOfAnalogChannels() { return AnalogChannelCount; }
+
+protected:
+
+	std::string FileName;
+
+	int BoardId;
+	int SampleRate;
+	int ExgChannelCount;
+	int AccelChannelCount;
+	int OtherChannelCount;
+	int AnalogChannelCount;
+};
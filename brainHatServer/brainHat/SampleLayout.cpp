@@ -0,0 +1,48 @@
+#include "SampleLayout.h"
+
+using namespace std;
+
+
+//  Generic implementations, for boards without a compile time layout
+//
+void MultiplexSamplesGeneric(const SampleBlock* block, int first, int count, double* raw)
+{
+	const int rows = block->SampleSize();
+	for (int j = 0; j < count; j++)
+		block->AsRawSample(first + j, raw + (j * rows));
+}
+
+
+int AppendSamplesGeneric(SampleBlock* toBlock, const SampleBlock* fromBlock, int fromSample, int count)
+{
+	return toBlock->AppendSamples(fromBlock, fromSample, count);
+}
+
+
+SampleBlockFunctions CytonFunctions = { MultiplexSamples<CytonLayout>, AppendSamples<CytonLayout> };
+SampleBlockFunctions CytonDaisyFunctions = { MultiplexSamples<CytonDaisyLayout>, AppendSamples<CytonDaisyLayout> };
+SampleBlockFunctions GenericFunctions = { MultiplexSamplesGeneric, AppendSamplesGeneric };
+
+
+//  Get the functions for a layout
+//
+const SampleBlockFunctions& GetSampleBlockFunctions(int exgChannels, int accelChannels, int otherChannels, int analogChannels)
+{
+	if (accelChannels == CytonLayout::AccelChannels && otherChannels == CytonLayout::OtherChannels && analogChannels == CytonLayout::AnalogChannels)
+	{
+		if (exgChannels == CytonLayout::ExgChannels)
+			return CytonFunctions;
+		else if (exgChannels == CytonDaisyLayout::ExgChannels)
+			return CytonDaisyFunctions;
+	}
+
+	return GenericFunctions;
+}
+
+
+//  Get the functions for the layout of this block
+//
+const SampleBlockFunctions& GetSampleBlockFunctions(const SampleBlock* block)
+{
+	return GetSampleBlockFunctions(block->GetNumberOfExgChannels(), block->GetNumberOfAccelChannels(), block->GetNumberOfOtherChannels(), block->GetNumberOfAnalogChannels());
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <string.h>
+#include "SampleBlock.h"
+
+
+//  Sample Layout
+//  Compile time description of the rows in a sample block for a board
+//  the order is the same as SampleBlock:  sample index, exg, accel, other, analog, time stamp
+//
+template <int EXG, int ACCEL, int OTHER, int ANALOG>
+struct SampleLayout
+{
+	static const int ExgChannels = EXG;
+	static const int AccelChannels = ACCEL;
+	static const int OtherChannels = OTHER;
+	static const int AnalogChannels = ANALOG;
+
+	static const int SampleIndexOffset = 0;
+	static const int ExgOffset = 1;
+	static const int AccelOffset = ExgOffset + EXG;
+	static const int OtherOffset = AccelOffset + ACCEL;
+	static const int AnalogOffset = OtherOffset + OTHER;
+	static const int TimeStampOffset = AnalogOffset + ANALOG;
+	static const int Rows = TimeStampOffset + 1;
+};
+
+//  Layouts of the boards supported by the server (brainflow rows for the Cyton family)
+typedef SampleLayout<8, 3, 7, 3> CytonLayout;
+typedef SampleLayout<16, 3, 7, 3> CytonDaisyLayout;
+
+//  Contec frames, twenty channels, and the frame trailer byte in the other channel
+typedef SampleLayout<20, 0, 1, 0> ContecLayout;
+
+
+//  Sample Block Functions
+//  The per block operations on the hot path, selected once for the board layout
+//  so the loops inside run with compile time row counts and offsets
+//
+struct SampleBlockFunctions
+{
+	//  write count samples starting at first, one after the other, SampleSize() values each (sample major)
+	void(*Multiplex)(const SampleBlock* block, int first, int count, double* raw);
+
+	//  copy count samples into the end of another block with the same layout, returns samples copied
+	int(*Append)(SampleBlock* toBlock, const SampleBlock* fromBlock, int fromSample, int count);
+};
+
+
+//  Get the functions for a layout, specialized for the supported boards and generic for everything else
+const SampleBlockFunctions& GetSampleBlockFunctions(int exgChannels, int accelChannels, int otherChannels, int analogChannels);
+const SampleBlockFunctions& GetSampleBlockFunctions(const SampleBlock* block);
+
+
+
+//  Template implementations
+//
+
+template <class Layout>
+void MultiplexSamples(const SampleBlock* block, int first, int count, double* raw)
+{
+	const int capacity = block->GetCapacity();
+	const double* data = block->Row(0) + first;
+
+	for (int j = 0; j < count; j++)
+	{
+		double* out = raw + (j * Layout::Rows);
+		for (int r = 0; r < Layout::Rows; r++)
+			out[r] = data[(r * capacity) + j];
+	}
+}
+
+
+template <class Layout>
+int AppendSamples(SampleBlock* toBlock, const SampleBlock* fromBlock, int fromSample, int count)
+{
+	if (count > fromBlock->GetNumberOfSamples() - fromSample)
+		count = fromBlock->GetNumberOfSamples() - fromSample;
+	if (count > toBlock->GetCapacity() - toBlock->GetNumberOfSamples())
+		count = toBlock->GetCapacity() - toBlock->GetNumberOfSamples();
+	if (count <= 0)
+		return 0;
+
+	const int toSample = toBlock->GetNumberOfSamples();
+	for (int r = 0; r < Layout::Rows; r++)
+		memcpy(toBlock->Row(r) + toSample, fromBlock->Row(r) + fromSample, count * sizeof(double));
+	memcpy(toBlock->ValidityRow() + toSample, fromBlock->ValidityRow() + fromSample, count);
+
+	toBlock->SetNumberOfSamples(toSample + count);
+	return count;
+}
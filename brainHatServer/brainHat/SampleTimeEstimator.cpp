@@ -0,0 +1,210 @@
+#include <math.h>
+#include "SampleTimeEstimator.h"
+#include "TimeExtensions.h"
+
+using namespace std;
+using namespace chrono;
+
+
+//  Constructor
+//
+SampleTimeEstimator::SampleTimeEstimator()
+{
+	WindowCounts.resize(TIMEESTIMATOR_WINDOWSIZE);
+	WindowTimes.resize(TIMEESTIMATOR_WINDOWSIZE);
+
+	Configure(250, 1);
+}
+
+
+//  Set the board properties
+//
+void SampleTimeEstimator::Configure(int sampleRate, int indexStep)
+{
+	SampleRate = sampleRate > 0 ? sampleRate : 1;
+	IndexStep = indexStep > 0 ? indexStep : 1;
+	NominalPeriod = 1.0 / SampleRate;
+	Anchors = 0;
+
+	Reset();
+}
+
+
+//  Forget the fit
+//
+void SampleTimeEstimator::Reset()
+{
+	LastIndex = -1;
+	SampleCount = 0;
+
+	WindowStart = 0;
+	WindowCount = 0;
+	Suspect = false;
+
+	AnchorCount = 0;
+	AnchorUnixTime = 0.0;
+	Offset = 0.0;
+	Period = NominalPeriod;
+
+	LastTimeStamp = 0.0;
+	DriftPpm = 0.0;
+	Residual = 0.0;
+}
+
+
+//  Add a chunk read now, and calculate the sample times
+//
+void SampleTimeEstimator::AddChunk(const double* sampleIndex, int samples, double* timeStamps)
+{
+	if (samples <= 0)
+		return;
+
+	auto timeNow = steady_clock::now();
+
+	//  unwrap the sample index into the sample count, the time stamps hold the count until the times are known
+	for (int i = 0; i < samples; i++)
+	{
+		int index = (int)sampleIndex[i];
+		if (LastIndex >= 0)
+		{
+			int difference = (index - LastIndex + 256) % 256;
+			int steps = (difference + (IndexStep / 2)) / IndexStep;
+			SampleCount += steps > 0 ? steps : 1;
+		}
+		LastIndex = index;
+		timeStamps[i] = (double)SampleCount;
+	}
+
+	if (WindowCount == 0)
+		Anchor(timeNow);
+
+	//  this read, the last sample in the chunk was received by now
+	double count = (double)(SampleCount - AnchorCount);
+	double time = duration_cast<duration<double>>(timeNow - AnchorTime).count();
+
+	//  a read that does not fit is either a late read, which is ignored, or a gap, which is confirmed by the next read not fitting either
+	if (fabs(time - (Offset + (Period * count))) > TIMEESTIMATOR_REANCHORSECONDS)
+	{
+		if (Suspect)
+		{
+			Anchor(timeNow);
+			count = 0.0;
+			time = 0.0;
+			AddToWindow(count, time);
+		}
+		else
+		{
+			Suspect = true;
+		}
+	}
+	else
+	{
+		Suspect = false;
+		AddToWindow(count, time);
+	}
+
+	//  sample times from the fit
+	for (int i = 0; i < samples; i++)
+	{
+		double timeStamp = AnchorUnixTime + Offset + (Period * (timeStamps[i] - AnchorCount));
+		if (timeStamp <= LastTimeStamp)
+			timeStamp = LastTimeStamp + 0.000001;
+
+		timeStamps[i] = timeStamp;
+		LastTimeStamp = timeStamp;
+	}
+}
+
+
+//  Start a new fit at the last sample read
+//
+void SampleTimeEstimator::Anchor(steady_clock::time_point timeNow)
+{
+	AnchorCount = SampleCount;
+	AnchorTime = timeNow;
+	AnchorUnixTime = GetUnixTimeMilliseconds() / 1000.0;
+	Anchors++;
+
+	WindowStart = 0;
+	WindowCount = 0;
+	Suspect = false;
+
+	Offset = 0.0;
+	Period = NominalPeriod;
+}
+
+
+//  Add a point to the regression window, and update the fit
+//
+void SampleTimeEstimator::AddToWindow(double count, double time)
+{
+	if (WindowCount == TIMEESTIMATOR_WINDOWSIZE)
+	{
+		WindowStart = (WindowStart + 1) % TIMEESTIMATOR_WINDOWSIZE;
+		WindowCount--;
+	}
+
+	int next = (WindowStart + WindowCount) % TIMEESTIMATOR_WINDOWSIZE;
+	WindowCounts[next] = count;
+	WindowTimes[next] = time;
+	WindowCount++;
+
+	//  drop points older than the window time span
+	while (WindowCount > 2 && time - WindowTimes[WindowStart] > TIMEESTIMATOR_WINDOWSECONDS)
+	{
+		WindowStart = (WindowStart + 1) % TIMEESTIMATOR_WINDOWSIZE;
+		WindowCount--;
+	}
+
+	Fit();
+}
+
+
+//  Linear regression of time against sample count over the window
+//  until the window spans a second of samples, the period is held at the nominal period and only the offset is fit
+//
+void SampleTimeEstimator::Fit()
+{
+	double sumCount = 0.0, sumTime = 0.0;
+	for (int i = 0; i < WindowCount; i++)
+	{
+		int j = (WindowStart + i) % TIMEESTIMATOR_WINDOWSIZE;
+		sumCount += WindowCounts[j];
+		sumTime += WindowTimes[j];
+	}
+	double meanCount = sumCount / WindowCount;
+	double meanTime = sumTime / WindowCount;
+
+	double first = WindowCounts[WindowStart];
+	double last = WindowCounts[(WindowStart + WindowCount - 1) % TIMEESTIMATOR_WINDOWSIZE];
+
+	if (WindowCount > 2 && last - first >= SampleRate)
+	{
+		double sxy = 0.0, sxx = 0.0;
+		for (int i = 0; i < WindowCount; i++)
+		{
+			int j = (WindowStart + i) % TIMEESTIMATOR_WINDOWSIZE;
+			double dx = WindowCounts[j] - meanCount;
+			sxy += dx * (WindowTimes[j] - meanTime);
+			sxx += dx * dx;
+		}
+
+		Period = sxy / sxx;
+		DriftPpm = ((NominalPeriod / Period) - 1.0) * 1000000.0;
+	}
+	else
+	{
+		Period = NominalPeriod;
+	}
+
+	Offset = meanTime - (Period * meanCount);
+
+	double sumSquares = 0.0;
+	for (int i = 0; i < WindowCount; i++)
+	{
+		int j = (WindowStart + i) % TIMEESTIMATOR_WINDOWSIZE;
+		double error = WindowTimes[j] - (Offset + (Period * WindowCounts[j]));
+		sumSquares += error * error;
+	}
+	Residual = sqrt(sumSquares / WindowCount);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <chrono>
+
+//  number of reads in the regression window, and the longest time span it covers
+#define TIMEESTIMATOR_WINDOWSIZE (256)
+#define TIMEESTIMATOR_WINDOWSECONDS (30.0)
+
+//  difference between the fitted time and the read time that is treated as a gap, and restarts the fit
+#define TIMEESTIMATOR_REANCHORSECONDS (0.25)
+
+
+//  Sample Time Estimator
+//  Reconstructs sample times from the board sample index instead of the time each chunk was read
+//
+//  the rolling sample index is unwrapped into a continuous sample count, and each read adds a point (sample count, read time)
+//  a linear regression over a window of recent reads gives the sample period of the board crystal against the monotonic clock,
+//  and sample times are taken from the fit, so they are smooth and do not carry the scheduler jitter of the read times
+//  the fit is converted to unix time with the offset between the system clock and the monotonic clock at the anchor
+//
+//  when a read does not fit (samples lost for longer than the index roll over, board restarted, thread stalled) the fit is re-anchored
+//
+class SampleTimeEstimator
+{
+public:
+	SampleTimeEstimator();
+
+	//  sample rate of the board, and how much the sample index increments for each sample
+	void Configure(int sampleRate, int indexStep);
+
+	//  forget the fit, the next read starts a new one
+	void Reset();
+
+	//  add a chunk of samples read now, and fill in the time stamp (unix seconds) for each sample
+	void AddChunk(const double* sampleIndex, int samples, double* timeStamps);
+
+	//  difference between the board sample rate and the nominal sample rate, parts per million
+	double GetDriftPpm() { return DriftPpm; }
+
+	//  standard deviation of the read times around the fit, seconds
+	double GetResidual() { return Residual; }
+
+	int GetNumberOfAnchors() { return Anchors; }
+	int GetWindowSize() { return WindowCount; }
+
+protected:
+
+	int SampleRate;
+	int IndexStep;
+	double NominalPeriod;
+
+	//  unwrapped sample count
+	int LastIndex;
+	long long SampleCount;
+
+	//  regression window, sample count and monotonic time relative to the anchor
+	std::vector<double> WindowCounts;
+	std::vector<double> WindowTimes;
+	int WindowStart;
+	int WindowCount;
+
+	//  the last read did not fit the window
+	bool Suspect;
+
+	//  anchor of the fit
+	long long AnchorCount;
+	std::chrono::steady_clock::time_point AnchorTime;
+	double AnchorUnixTime;
+	int Anchors;
+
+	//  the fit, time = Offset + (Period * count) relative to the anchor
+	double Offset;
+	double Period;
+
+	double LastTimeStamp;
+	double DriftPpm;
+	double Residual;
+
+	void Anchor(std::chrono::steady_clock::time_point timeNow);
+	void AddToWindow(double count, double time);
+	void Fit();
+};
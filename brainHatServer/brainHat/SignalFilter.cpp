@@ -0,0 +1,237 @@
+#include <math.h>
+#include <algorithm>
+
+#include "SignalFilter.h"
+
+using namespace std;
+
+
+//  Constructor, the filter passes the input through until it is set
+//
+BiquadFilter::BiquadFilter()
+{
+	B0 = 1.0;
+	B1 = B2 = A1 = A2 = 0.0;
+	Z1 = Z2 = 0.0;
+}
+
+
+//  Low pass
+//
+void BiquadFilter::SetLowPass(double sampleRate, double cutoff, double q)
+{
+	double w0 = 2.0 * M_PI * cutoff / sampleRate;
+	double alpha = sin(w0) / (2.0 * q);
+	double cosw0 = cos(w0);
+	double a0 = 1.0 + alpha;
+
+	B0 = ((1.0 - cosw0) / 2.0) / a0;
+	B1 = (1.0 - cosw0) / a0;
+	B2 = B0;
+	A1 = (-2.0 * cosw0) / a0;
+	A2 = (1.0 - alpha) / a0;
+	Z1 = Z2 = 0.0;
+}
+
+
+//  High pass
+//
+void BiquadFilter::SetHighPass(double sampleRate, double cutoff, double q)
+{
+	double w0 = 2.0 * M_PI * cutoff / sampleRate;
+	double alpha = sin(w0) / (2.0 * q);
+	double cosw0 = cos(w0);
+	double a0 = 1.0 + alpha;
+
+	B0 = ((1.0 + cosw0) / 2.0) / a0;
+	B1 = -(1.0 + cosw0) / a0;
+	B2 = B0;
+	A1 = (-2.0 * cosw0) / a0;
+	A2 = (1.0 - alpha) / a0;
+	Z1 = Z2 = 0.0;
+}
+
+
+//  Set the section from a conjugate pair of poles and a conjugate pair of zeros
+//
+void BiquadFilter::SetPolesZeros(complex<double> pole, complex<double> zero)
+{
+	double b1 = -2.0 * zero.real();
+	double b2 = norm(zero);
+	A1 = -2.0 * pole.real();
+	A2 = norm(pole);
+
+	double gain = (1.0 + A1 + A2) / (1.0 + b1 + b2);
+	B0 = gain;
+	B1 = gain * b1;
+	B2 = gain * b2;
+	Z1 = Z2 = 0.0;
+}
+
+
+//  Set the state to the steady state for a constant input
+//
+double BiquadFilter::Prime(double input)
+{
+	double output = input * (B0 + B1 + B2) / (1.0 + A1 + A2);
+	Z2 = B2 * input - A2 * output;
+	Z1 = B1 * input - A1 * output + Z2;
+	return output;
+}
+
+
+
+//  Q of each section of a Butterworth filter of the order
+//
+vector<double> FilterChain::ButterworthQ(int order)
+{
+	vector<double> q;
+	int sections = (order + 1) / 2;
+	int poles = sections * 2;
+	for (int k = 0; k < sections; k++)
+		q.push_back(1.0 / (2.0 * cos(M_PI * (2 * k + 1) / (2.0 * poles))));
+
+	return q;
+}
+
+
+//  Poles of the Chebyshev type I low pass prototype, the upper half of each conjugate pair, then the real pole of an odd order
+//
+vector<complex<double>> FilterChain::ChebyshevPoles(int order, double rippleDb)
+{
+	vector<complex<double>> poles;
+	double epsilon = sqrt(pow(10.0, rippleDb / 10.0) - 1.0);
+	double v0 = asinh(1.0 / epsilon) / order;
+
+	for (int k = 1 - order; k < 0; k += 2)
+		poles.push_back(complex<double>(-sinh(v0) * cos(k * M_PI / (2.0 * order)), cosh(v0) * sin(k * M_PI / (2.0 * order))));
+
+	if (order % 2 == 1)
+		poles.push_back(complex<double>(-sinh(v0), 0.0));
+
+	return poles;
+}
+
+
+//  Map an analog low pass prototype pole or zero to the two digital band stop roots,
+//  the bilinear transform and then the Constantinides low pass to band stop transform, as in DSPFilters
+//
+static pair<complex<double>, complex<double>> BandStopTransform(complex<double> c, bool infinite, double a, double b)
+{
+	if (infinite)
+		c = -1.0;
+	else
+		c = (1.0 + c) / (1.0 - c);
+
+	double a2 = a * a;
+	double b2 = b * b;
+
+	complex<double> u = sqrt((4.0 * (b2 + a2 - 1.0) * c + 8.0 * (b2 - a2 + 1.0)) * c + 4.0 * (a2 + b2 - 1.0));
+	complex<double> v = a - a * c - 0.5 * u;
+	u = a - a * c + 0.5 * u;
+	complex<double> d = (b + 1.0) + (b - 1.0) * c;
+
+	return make_pair(u / d, v / d);
+}
+
+
+//  Constructor
+//
+FilterChain::FilterChain()
+{
+	LastInput = 0.0;
+}
+
+
+//  Add a Butterworth low pass
+//
+void FilterChain::AddLowPass(double sampleRate, double cutoff, int order)
+{
+	for (auto q : ButterworthQ(order))
+	{
+		BiquadFilter section;
+		section.SetLowPass(sampleRate, cutoff, q);
+		Sections.push_back(section);
+	}
+}
+
+
+//  Add a Butterworth high pass
+//
+void FilterChain::AddHighPass(double sampleRate, double cutoff, int order)
+{
+	for (auto q : ButterworthQ(order))
+	{
+		BiquadFilter section;
+		section.SetHighPass(sampleRate, cutoff, q);
+		Sections.push_back(section);
+	}
+}
+
+
+//  Add a Chebyshev type I band stop
+//
+void FilterChain::AddBandStop(double sampleRate, double center, double bandwidth, int order, double rippleDb)
+{
+	double ww = 2.0 * M_PI * bandwidth / sampleRate;
+	double wLow = max(2.0 * M_PI * center / sampleRate - ww / 2.0, 1e-8);
+	double wHigh = min(wLow + ww, M_PI - 1e-8);
+	double a = cos((wHigh + wLow) * 0.5) / cos((wHigh - wLow) * 0.5);
+	double b = tan((wHigh - wLow) * 0.5);
+
+	auto zeros = BandStopTransform(0.0, true, a, b);
+	for (auto pole : ChebyshevPoles(order, rippleDb))
+	{
+		auto poles = BandStopTransform(pole, false, a, b);
+
+		BiquadFilter first;
+		first.SetPolesZeros(poles.first, zeros.first);
+		Sections.push_back(first);
+
+		//  the real pole of an odd order maps to one conjugate pair
+		if (pole.imag() == 0.0)
+			continue;
+
+		BiquadFilter second;
+		second.SetPolesZeros(poles.second, zeros.second);
+		Sections.push_back(second);
+	}
+
+	//  an even order Chebyshev response is at the bottom of its ripple at DC
+	if (order % 2 == 0 && Sections.size() > 0)
+		Sections.back().Scale(pow(10.0, -rippleDb / 20.0));
+}
+
+
+//  Start filtering from a constant input
+//
+void FilterChain::Prime(double input)
+{
+	LastInput = input;
+	for (auto& section : Sections)
+		input = section.Prime(input);
+}
+
+
+//  Filter count samples
+//
+void FilterChain::Process(const double* input, double* output, int count)
+{
+	int sections = (int)Sections.size();
+	BiquadFilter* section = Sections.data();
+
+	for (int i = 0; i < count; i++)
+	{
+		double value = input[i];
+		bool missing = isnan(value);
+		if (missing)
+			value = LastInput;
+		else
+			LastInput = value;
+
+		for (int j = 0; j < sections; j++)
+			value = section[j].Process(value);
+
+		output[i] = missing ? NAN : value;
+	}
+}
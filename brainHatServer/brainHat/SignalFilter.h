@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <complex>
+
+
+//  Biquad Filter
+//  One second order section, for filtering a stream of samples one at a time
+//
+//  coefficients are from the RBJ audio EQ cookbook, the section is direct form II transposed,
+//  so the state carries over from one block of samples to the next
+//
+class BiquadFilter
+{
+public:
+	BiquadFilter();
+
+	//  set the response, Q of 0.7071 is a second order Butterworth
+	void SetLowPass(double sampleRate, double cutoff, double q);
+	void SetHighPass(double sampleRate, double cutoff, double q);
+
+	//  set the section from its poles and zeros, each a complex conjugate pair, scaled to a gain of one at DC
+	void SetPolesZeros(std::complex<double> pole, std::complex<double> zero);
+
+	//  scale the gain of the section
+	void Scale(double gain) { B0 *= gain; B1 *= gain; B2 *= gain; }
+
+	//  set the state to the steady state for a constant input, returns the steady state output
+	double Prime(double input);
+
+	inline double Process(double input)
+	{
+		double output = B0 * input + Z1;
+		Z1 = B1 * input - A1 * output + Z2;
+		Z2 = B2 * input - A2 * output;
+		return output;
+	}
+
+protected:
+
+	double B0, B1, B2, A1, A2;
+	double Z1, Z2;
+};
+
+
+
+//  Filter Chain
+//  Biquad sections in series, applied to one channel
+//
+class FilterChain
+{
+public:
+	FilterChain();
+
+	void Clear() { Sections.clear(); }
+
+	//  Butterworth responses, order is rounded up to even, two poles per section
+	void AddLowPass(double sampleRate, double cutoff, int order);
+	void AddHighPass(double sampleRate, double cutoff, int order);
+
+	//  Chebyshev type I band stop, the same design as brainflow perform_bandstop,
+	//  order is of the low pass prototype, one section for each pole of the prototype, ripple is the pass band ripple in dB
+	void AddBandStop(double sampleRate, double center, double bandwidth, int order, double rippleDb);
+
+	//  start filtering from a constant input, so the chain does not ring from the DC offset of the first sample
+	void Prime(double input);
+
+	//  filter count samples, in place is allowed
+	//  NaN samples are passed through, the filters keep time with the last sample before them
+	void Process(const double* input, double* output, int count);
+
+protected:
+
+	std::vector<BiquadFilter> Sections;
+	double LastInput;
+
+	static std::vector<double> ButterworthQ(int order);
+	static std::vector<std::complex<double>> ChebyshevPoles(int order, double rippleDb);
+};
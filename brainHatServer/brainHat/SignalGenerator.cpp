@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <thread>
+
+#include "brainHat.h"
+#include "SignalGenerator.h"
+#include "StringExtensions.h"
+#include "BoardIds.h"
+
+using namespace std;
+using namespace chrono;
+
+
+//  Signal Generator, makes synthetic samples
+//  Construct with callback functions:
+//    -  ConnectionChanged will be called on first discovery of board parameters, then on connect / disconnect state
+//    -  NewSample will be called when new samples are made
+//
+SignalGenerator::SignalGenerator(ConnectionChangedCallbackFn connectionChangedFn, NewSampleCallbackFn newSampleFn)
+{
+	ConnectionChangedCallback = connectionChangedFn;
+	NewSampleCallback = newSampleFn;
+
+	BoardOn = true;
+	IsConnected = true;
+	StreamRunning = false;
+	RequestToggleStreaming = false;
+
+	StreamStartWallTime = 0.0;
+	StreamStartSample = 0;
+	SampleCounter = 0;
+	RandomState = 2463534242u;
+}
+
+
+//  Destructor
+//
+SignalGenerator::~SignalGenerator()
+{
+	Cancel();
+}
+
+
+//  Describe the source of the data
+//
+string SignalGenerator::ReportSource()
+{
+	return format("Signal generator %d channels at %d Hz", ExgChannelCount, SampleRate);
+}
+
+
+//  Set the signal
+//
+void SignalGenerator::SetSignal(SignalGeneratorSettings settings)
+{
+	Signal = settings;
+}
+
+
+//  Thread Start
+//
+int SignalGenerator::Start(int boardId, struct BrainFlowInputParams params, bool srb1On)
+{
+	if (Signal.ExgChannels <= 0 || Signal.SampleRate <= 0)
+		return 1;
+
+	BoardId = boardId;
+	SampleRate = Signal.SampleRate;
+	ExgChannelCount = Signal.ExgChannels;
+	AccelChannelCount = 0;
+	OtherChannelCount = 1;
+	AnalogChannelCount = 0;
+	DataRows = 3 + ExgChannelCount;
+
+	//  channel frequencies are whole numbers from 6 to 30 Hz, so the sines repeat every second,
+	//  the artifact is strongest on the first channels
+	SineStep.resize(ExgChannelCount);
+	ArtifactWeight.resize(ExgChannelCount);
+	PinkState.assign(ExgChannelCount * 3, 0.0);
+	for (int i = 0; i < ExgChannelCount; i++)
+	{
+		SineStep[i] = 2.0 * M_PI * (6.0 + (i % 25)) / SampleRate;
+		ArtifactWeight[i] = 1.0 / (1.0 + i / 4.0);
+	}
+
+	ConfigureBlockPool();
+	ConnectionChanged(New, BoardId, SampleRate);
+
+	LastSampleIndex = -1;
+	StartStreaming();
+
+	Thread::Start();
+
+	return 0;
+}
+
+
+//  Public funciton to toggle streaming
+//
+bool SignalGenerator::RequestEnableStreaming(bool enable)
+{
+	if ((enable && !StreamRunning) || (!enable && StreamRunning))
+		RequestToggleStreaming = true;
+
+	return true;
+}
+
+
+//  Start streaming, the stream clock starts again from now
+//
+void SignalGenerator::StartStreaming()
+{
+	if (!StreamRunning)
+	{
+		StreamStartTime = steady_clock::now();
+		StreamStartWallTime = GetUnixTimeSeconds();
+		StreamStartSample = SampleCounter;
+
+		StreamRunning = true;
+		ConnectionChanged(StreamOn, BoardId, SampleRate);
+	}
+}
+
+
+//  Stop streaming
+//
+void SignalGenerator::StopStreaming()
+{
+	if (StreamRunning)
+	{
+		StreamRunning = false;
+		ConnectionChanged(StreamOff, BoardId, SampleRate);
+	}
+}
+
+
+//  Thread Run Function
+//
+void SignalGenerator::RunFunction()
+{
+	auto nextTick = steady_clock::now();
+
+	while (ThreadRunning)
+	{
+		if (RequestToggleStreaming)
+		{
+			if (StreamRunning)
+				StopStreaming();
+			else
+				StartStreaming();
+
+			RequestToggleStreaming = false;
+			continue;
+		}
+
+		if (!BoardOn || !StreamRunning)
+		{
+			usleep(100 * USLEEP_MILI);
+			continue;
+		}
+
+		//  samples due by now
+		double elapsed = duration<double>(steady_clock::now() - StreamStartTime).count();
+		long long due = (long long)(elapsed * SampleRate) - (SampleCounter - StreamStartSample);
+		if (due <= 0)
+		{
+			auto now = steady_clock::now();
+			while (nextTick <= now)
+				nextTick += milliseconds(SIGNALGENERATOR_TICKMS);
+			this_thread::sleep_until(nextTick);
+			continue;
+		}
+
+		int count = due > BlockPool.GetBlockCapacity() ? BlockPool.GetBlockCapacity() : (int)due;
+
+		SampleBlock* block = BlockPool.Get(count);
+		GenerateSamples(block, count);
+
+		InspectDataStream(block);
+
+		NewSample(block);
+		block->Release();
+
+		if (LastLoggedStatusTime.ElapsedMilliseconds() > 5000)
+		{
+			Logging.AddLog("SignalGenerator", "RunFunction", format("Generated %lld samples.", SampleCounter), LogLevelTrace);
+			LastLoggedStatusTime.Reset();
+		}
+	}
+}
+
+
+//  White noise from -1 to 1, xorshift
+//
+double SignalGenerator::WhiteNoise()
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+
+	return (RandomState / 2147483648.0) - 1.0;
+}
+
+
+//  Fill the block with the next count samples
+//  pink noise is white noise through three one pole filters (Paul Kellet's economy filter)
+//
+void SignalGenerator::GenerateSamples(SampleBlock* block, int count)
+{
+	block->SetNumberOfSamples(count);
+
+	int artifactSamples = (int)(SIGNALGENERATOR_ARTIFACTSECONDS * SampleRate);
+	long long artifactPeriod = (long long)(Signal.ArtifactInterval * SampleRate);
+
+	double* sampleIndex = block->SampleIndexRow();
+	double* artifactRow = block->OtherRow(0);
+	double* timeStamps = block->TimeStampRow();
+	for (int s = 0; s < count; s++)
+	{
+		long long n = SampleCounter + s;
+		sampleIndex[s] = (double)(n % 256);
+		timeStamps[s] = StreamStartWallTime + (double)(n - StreamStartSample) / SampleRate;
+
+		artifactRow[s] = (artifactPeriod > 0 && (n % artifactPeriod) < artifactSamples) ? 1.0 : 0.0;
+	}
+
+	//  one channel at a time, so each row is written in order
+	for (int i = 0; i < ExgChannelCount; i++)
+	{
+		double* row = block->ExgRow(i);
+		double* pink = &PinkState[i * 3];
+		for (int s = 0; s < count; s++)
+		{
+			long long n = SampleCounter + s;
+
+			double white = WhiteNoise();
+			pink[0] = 0.99765 * pink[0] + white * 0.0990460;
+			pink[1] = 0.96300 * pink[1] + white * 0.2965164;
+			pink[2] = 0.57000 * pink[2] + white * 1.0526913;
+			double noise = (pink[0] + pink[1] + pink[2] + white * 0.1848) / 3.0;
+
+			row[s] = Signal.SineAmplitude * sin(SineStep[i] * (double)(n % SampleRate)) + Signal.NoiseAmplitude * noise;
+			if (artifactRow[s] != 0.0)
+				row[s] += ArtifactWeight[i] * SIGNALGENERATOR_ARTIFACTUV * sin(M_PI * (n % artifactPeriod) / artifactSamples);
+		}
+	}
+
+	memset(block->ValidityRow(), 1, count);
+
+	SampleCounter += count;
+	LastTimeStampSync = timeStamps[count - 1];
+}
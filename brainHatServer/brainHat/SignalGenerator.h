@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "BoardDataSource.h"
+#include "SampleBlock.h"
+#include "TimeExtensions.h"
+
+//  generator tick, samples due in each tick are published together
+#define SIGNALGENERATOR_TICKMS (4)
+
+//  blink artifact length and peak, microvolts
+#define SIGNALGENERATOR_ARTIFACTSECONDS (0.3)
+#define SIGNALGENERATOR_ARTIFACTUV (100.0)
+
+
+//  Signal generator settings, from the command line
+//
+struct SignalGeneratorSettings
+{
+public:
+
+	int ExgChannels;
+	int SampleRate;
+	//
+	//  amplitude of the sine on each channel, and of the pink noise, microvolts
+	double SineAmplitude;
+	double NoiseAmplitude;
+	//
+	//  seconds between blink artifacts, zero for none
+	double ArtifactInterval;
+
+	SignalGeneratorSettings()
+	{
+		ExgChannels = 64;
+		SampleRate = 4000;
+		SineAmplitude = 10.0;
+		NoiseAmplitude = 5.0;
+		ArtifactInterval = 5.0;
+	}
+};
+
+
+//  Signal Generator
+//  A data source that makes synthetic EEG, at any number of channels and sample rate, to load test the server without hardware
+//
+//  each channel is a sine at its own frequency plus pink noise, with a blink artifact on the front channels at a fixed interval,
+//  the other channel is 1 while an artifact is running, and the sample index rolls over at 256 like the Cyton
+//  samples are published against a monotonic clock, on each tick every sample due is published in one block
+//
+class SignalGenerator : public BoardDataSource
+{
+public:
+	SignalGenerator(ConnectionChangedCallbackFn connectionChangedFn, NewSampleCallbackFn newSampleFn);
+	virtual ~SignalGenerator();
+
+	//  set the signal before starting
+	void SetSignal(SignalGeneratorSettings settings);
+
+	virtual int Start(int boardId, struct BrainFlowInputParams params, bool srb1On);
+
+	virtual void RunFunction();
+
+	virtual bool GetIsStreamRunning() { return StreamRunning; }
+
+	virtual bool RequestEnableStreaming(bool enable);
+
+protected:
+
+	virtual std::string ReportSource();
+
+	SignalGeneratorSettings Signal;
+
+	bool RequestToggleStreaming;
+	void StartStreaming();
+	void StopStreaming();
+
+	//  stream clock, the wall clock and the sample count when the stream started
+	std::chrono::steady_clock::time_point StreamStartTime;
+	double StreamStartWallTime;
+	long long StreamStartSample;
+
+	//  signal state
+	long long SampleCounter;
+	unsigned int RandomState;
+	std::vector<double> SineStep;
+	std::vector<double> ArtifactWeight;
+	std::vector<double> PinkState;
+	//
+	double WhiteNoise();
+	void GenerateSamples(SampleBlock* block, int count);
+
+	ChronoTimer LastLoggedStatusTime;
+};
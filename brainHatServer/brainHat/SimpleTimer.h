@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <future>
+#include <thread>
 
 
 //  Simple Timer class
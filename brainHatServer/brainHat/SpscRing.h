@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+
+#define CACHE_LINE_SIZE (64)
+
+
+//  SPSC Ring
+//  Bounded, lock free, single producer / single consumer ring buffer
+//  Push() and DropOldest() may only be called from one thread, and Pop() / PopBatch() from one other thread
+//  capacity is rounded up to a power of two
+//
+//  Head is written only by the producer, and is on its own cache line away from Tail
+//  Tail is advanced by the consumer, and also by the producer when it drops the oldest item, so it is advanced with compare and swap
+//  the statistics are updated by the producer, and can be read from any thread
+//
+template <class T>
+class SpscRing
+{
+public:
+
+	SpscRing(int capacity)
+	{
+		Items = NULL;
+		Resize(capacity);
+	}
+
+	//  set the capacity, the ring is emptied and the statistics reset
+	//  not thread safe, only call when the producer and the consumer are not using the ring
+	void Resize(int capacity)
+	{
+		if (Items != NULL)
+			delete[] Items;
+
+		Capacity = 1;
+		while ((int)Capacity < capacity)
+			Capacity <<= 1;
+		Mask = Capacity - 1;
+		Items = new std::atomic<T>[Capacity];
+
+		Head = 0;
+		Tail = 0;
+		Pushed = 0;
+		Overflows = 0;
+		MaxDepth = 0;
+	}
+
+	virtual ~SpscRing()
+	{
+		delete[] Items;
+	}
+
+
+	//  Producer
+	//  add an item, returns false if the ring is full (the item is not added, and the overflow is counted)
+	bool Push(const T& item)
+	{
+		unsigned int head = Head.load(std::memory_order_relaxed);
+		unsigned int depth = head - Tail.load(std::memory_order_acquire);
+		if (depth >= Capacity)
+		{
+			Overflows.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		Items[head & Mask].store(item, std::memory_order_relaxed);
+		Head.store(head + 1, std::memory_order_release);
+
+		Pushed.fetch_add(1, std::memory_order_relaxed);
+		if ((int)depth + 1 > MaxDepth.load(std::memory_order_relaxed))
+			MaxDepth.store(depth + 1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+
+	//  Producer
+	//  remove the oldest item to make room, returns false if the ring is empty or the consumer took the item first
+	bool DropOldest(T& item)
+	{
+		unsigned int tail = Tail.load(std::memory_order_acquire);
+		if (Head.load(std::memory_order_relaxed) == tail)
+			return false;
+
+		item = Items[tail & Mask].load(std::memory_order_relaxed);
+		return Tail.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel);
+	}
+
+	//  Producer
+	//  true if the next Push() would fail
+	bool IsFull() const
+	{
+		return Head.load(std::memory_order_relaxed) - Tail.load(std::memory_order_acquire) >= Capacity;
+	}
+
+
+	//  Consumer
+	//  take the oldest item, returns false if the ring is empty
+	bool Pop(T& item)
+	{
+		return PopBatch(&item, 1) == 1;
+	}
+
+	//  take up to maxItems of the oldest items in one pass, returns the number taken
+	//  if the producer dropped items while they were being copied, the copy is discarded and taken again
+	int PopBatch(T* items, int maxItems)
+	{
+		unsigned int tail = Tail.load(std::memory_order_acquire);
+		while (true)
+		{
+			unsigned int available = Head.load(std::memory_order_acquire) - tail;
+
+			int count = (int)available < maxItems ? (int)available : maxItems;
+			if (count == 0)
+				return 0;
+
+			for (int i = 0; i < count; i++)
+				items[i] = Items[(tail + i) & Mask].load(std::memory_order_relaxed);
+
+			if (Tail.compare_exchange_weak(tail, tail + count, std::memory_order_acq_rel))
+				return count;
+		}
+	}
+
+
+	//  Statistics
+	int GetCapacity() const { return Capacity; }
+	int GetDepth() const { return (int)(Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire)); }
+	bool IsEmpty() const { return GetDepth() == 0; }
+	unsigned long long GetPushed() const { return Pushed.load(std::memory_order_relaxed); }
+	unsigned long long GetOverflows() const { return Overflows.load(std::memory_order_relaxed); }
+	int GetMaxDepth() const { return MaxDepth.load(std::memory_order_relaxed); }
+
+
+protected:
+
+	//  not copyable
+	SpscRing(const SpscRing&);
+	SpscRing& operator=(const SpscRing&);
+
+	//  set at construction, read only after that
+	std::atomic<T>* Items;
+	unsigned int Capacity;
+	unsigned int Mask;
+
+	//  producer
+	char PadHead[CACHE_LINE_SIZE];
+	std::atomic<unsigned int> Head;
+	std::atomic<unsigned long long> Pushed;
+	std::atomic<unsigned long long> Overflows;
+	std::atomic<int> MaxDepth;
+
+	//  consumer
+	char PadTail[CACHE_LINE_SIZE];
+	std::atomic<unsigned int> Tail;
+	char PadEnd[CACHE_LINE_SIZE];
+};
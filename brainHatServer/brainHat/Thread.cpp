@@ -14,6 +14,76 @@ void Sleep(long millis)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//  Thread Signal
+//
+
+//  Constructor
+//
+ThreadSignal::ThreadSignal()
+{
+	Signaled = false;
+	Waiting = false;
+	Wakeups = 0;
+}
+
+
+//  Notify
+//  set the signal, and wake the thread if it is waiting
+//
+void ThreadSignal::Notify()
+{
+	Signaled = true;
+	
+	if (Waiting)
+	{
+		//  take the lock so the notification can not arrive between the waiting thread checking the signal and going to sleep
+		LockMutex lockSignal(SignalMutex);
+		SignalCondition.notify_one();
+	}
+}
+
+
+//  Wait until notified
+//
+void ThreadSignal::Wait()
+{
+	std::unique_lock<std::mutex> lockSignal(SignalMutex);
+	
+	Waiting = true;
+	SignalCondition.wait(lockSignal, [this] { return Signaled.load(); });
+	Waiting = false;
+	
+	Signaled = false;
+	Wakeups++;
+}
+
+
+//  Wait until notified or the timeout
+//
+bool ThreadSignal::WaitFor(long millis)
+{
+	return WaitUntil(std::chrono::steady_clock::now() + std::chrono::milliseconds(millis));
+}
+
+
+//  Wait until notified or the deadline
+//
+bool ThreadSignal::WaitUntil(std::chrono::steady_clock::time_point deadline)
+{
+	std::unique_lock<std::mutex> lockSignal(SignalMutex);
+	
+	Waiting = true;
+	bool signaled = SignalCondition.wait_until(lockSignal, deadline, [this] { return Signaled.load(); });
+	Waiting = false;
+	
+	Signaled = false;
+	Wakeups++;
+	return signaled;
+}
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 //  Thread
 //  base class for simple thread wrapper
@@ -89,12 +159,12 @@ void Thread::Start()
 void Thread::Cancel()
 {
 	ThreadRunning = false;
+	RunSignal.Notify();
 
 	if ( TheThread )
 	{
-		//  a proper cancel thread function should have an interrupt here, to kill the thread if it is sleeping
-		//  unfortunately, std::thread can not be interrupted (I believe?)
-		//  use the BoostThread class if you want an interruptable thread
+		//  a thread waiting on RunSignal has been woken up above
+		//  std::thread can not be interrupted, so a thread sleeping or blocked anywhere else has to finish that first
 
 		//  wait for the thread to stop
 		while ( ! ThreadStopped )
@@ -3,16 +3,54 @@
 
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 
 
 //  sleep in the current thread for millis milliseconds
 void Sleep(long millis);
 
+//  Thread Signal
+//  wake a waiting thread when there is work for it, instead of having it poll
+//  Notify() is cheap when nobody is waiting, it only takes the signal lock to wake a thread that is asleep
+//  a notification is remembered until the next wait returns, so it is never lost
+//
+class ThreadSignal
+{
+public:
+	ThreadSignal();
+
+	//  Wake the waiting thread
+	void Notify();
+
+	//  Wait until notified
+	void Wait();
+
+	//  Wait until notified or until the timeout, returns true if notified
+	bool WaitFor(long millis);
+	bool WaitUntil(std::chrono::steady_clock::time_point deadline);
+
+	//  Number of times the waiting thread has woken up, for measuring idle activity
+	unsigned long long GetWakeups() { return Wakeups; }
+
+protected:
+
+	std::mutex SignalMutex;
+	std::condition_variable SignalCondition;
+	std::atomic<bool> Signaled;
+	std::atomic<bool> Waiting;
+	std::atomic<unsigned long long> Wakeups;
+};
+
+
+
 //  Thread
 //  a simple framework for using std::thread 
 //  to have a thread, derive your class from Thread
 //  and then define  YourDerivedThreadClass::RunFunction()
 //  if you want to do specific shutdown when the thread is canceled, also override Cancel()
+//  RunFunction() should wait on RunSignal when it has nothing to do, Cancel() notifies it so the thread exits promptly
 //
 
 
@@ -50,8 +88,14 @@ protected:
 	std::thread* TheThread;
 
 	//  running flags
-	bool ThreadRunning;
-	bool ThreadStopped;
+	std::atomic<bool> ThreadRunning;
+	std::atomic<bool> ThreadStopped;
+	
+	//  wakes the thread when there is work to do, or when canceled
+	ThreadSignal RunSignal;
+	
+public:
+	unsigned long long GetWakeups() { return RunSignal.GetWakeups(); }
 };
 
 
@@ -23,6 +23,14 @@ inline long long GetUnixTimeMilliseconds()
 }
 
 
+inline double GetUnixTimeSeconds()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+
 inline bool SetSystemTime(int year, int month, int day, int hour, int minute, int second, int microseconds)
 {
 	struct tm setTimeStruct;
@@ -6,23 +6,18 @@
 
 #include <wiringPi.h>
 #include <list>
+#include <vector>
 
 #include "brainHat.h"
 #include "Logger.h"
 #include "StringExtensions.h"
-#include "BroadcastData.h"
-#include "BroadcastStatus.h"
-#include "BoardDataReader.h"
+#include "BoardSession.h"
 #include "CommandServer.h"
-#include "OpenBciDataFile.h"
-#include "BDFFileWriter.h"
-#include "BoardFileSimulator.h"
 #include "TimeExtensions.h"
 #include "NetworkExtensions.h"
 #include "Parser.h"
 #include "UriParser.h"
 #include "BoardIds.h"
-#include "BrainHatFileWriter.h"
 #include "PinController.h"
 #include "GpioControl.h"
 
@@ -31,48 +26,30 @@
 
 using namespace std;
 
-//  Callback Functions for component state changes
-void OnBoardConnectionStateChanged(BoardConnectionStates state, int boardId, int sampleRate);
-void OnLslConnectionStateChanged(bool connected);
-void OnRecordingStateChanged(bool recording);
-
-//  Callback function for sample received
-void OnNewSample(BFSample* sample);
-
 //  Callback function for TCPIP server request to process
 bool OnServerRequest(string request);
 
 //  Program Components
 Logger Logging;
-BroadcastData DataBroadcaster(OnLslConnectionStateChanged);
-BroadcastStatus StatusBroadcaster;
 CommandServer ComServer(OnServerRequest);
 
 //  Command line arguments
-int BoardId = 0;
+//  settings for each board, and for the whole program
+vector<BoardSessionSettings> BoardSettings(1);
+int NamedBoards = 0;
 bool RecordToUsb = true;
-bool StartSrbOn = false;
-string DemoFileName = "";
-struct BrainFlowInputParams InputParams;
 
 
-//  Data Source
-BoardDataSource* DataSource = NULL;
+//  Board sessions, one for each board
+//  the first session is the primary session, it drives the status lights and handles requests with no device
+vector<BoardSession*> Sessions;
+BoardSession* FindSession(string device);
 
-//  Demo file reader
-BoardFileSimulator DemoFileReader(OnBoardConnectionStateChanged, OnNewSample);
-
-//  File Recorder
-BrainHatFileWriter* FileWriter;
-bool IsRecording() {return FileWriter != NULL && FileWriter->IsRecording();}
 
 //  Program functions
 bool ParseArguments(int argc, char *argv[]);
 bool parse_args(int argc, char *argv[]);
-void RunBoardData();
-void RunFileData();
 bool ProcessKeyboardInput(string input); 
-bool LiveData() { return BoardId != (int)BrainhatBoardIds::UNDEFINED; }
 
 
 //  Pin numbers for status LED
@@ -99,75 +76,22 @@ int main(int argc, char *argv[])
 	//  start logging thread
 	Logging.Start() ;
 	
-	//  start the tcpip command server
-	ComServer.Start();
-	
-	//  start board or file simulator data
-	if(LiveData())
-	{
-		RunBoardData();
-	}
-	else
-	{
-		RunFileData();
-	}
-	
-	//  shut down LED lights
-	StopGpioController();
-
-	// user quit, stop threads
-	DataBroadcaster.Cancel();
-	StatusBroadcaster.Cancel();
-	ComServer.Cancel();
-	Logging.Cancel();
-	
-	return 0;
-}
-
-
-
-//  Run the program with data from the live board
-//
-void RunBoardData()
-{	
-	switch ((BrainhatBoardIds)BoardId)
-	{
-	default:
-		DataSource = new BoardDataReader(OnBoardConnectionStateChanged, OnNewSample);
-		break;
-	}
-	
-	DataSource->Start(BoardId, InputParams, StartSrbOn);
-	
-	string input;
-	while (true)
+	//  start the boards or file simulator data
+	for (auto it = BoardSettings.begin(); it != BoardSettings.end(); ++it)
 	{
-		getline(cin, input);
-		toUpper(input);
+		auto session = new BoardSession(*it, Sessions.size() == 0);
+		Sessions.push_back(session);
 		
-		if (!ProcessKeyboardInput(input))
+		if (session->Start() != 0)
 		{
-			DataSource->Cancel();
-			break;
+			Logging.AddLog("main", "main", format("Unable to start %s.", it->LiveData() ? format("board %d", it->BoardId).c_str() : format("file %s", it->DemoFileName.c_str()).c_str()), LogLevelError);
 		}
 	}
-}
-
-
-//  Run the program with data from the demo file
-//
-void RunFileData()
-{
-	DataSource = &DemoFileReader;
 	
-	if (DemoFileReader.Start(DemoFileName) != 0)
-	{
-		Logging.AddLog("main", "RunFileData", "Unable to load file.", LogLevelError);
-		getchar();
-		return;
-	}
-
-	Logging.AddLog("main", "RunFileData", "Starting file data. Enter Q to quit.", LogLevelInfo);
+	//  start the tcpip command server, once all the sessions it looks up exist
+	ComServer.Start();
+	
+	Logging.AddLog("main", "main", format("Serving %d board%s. Enter Q to quit.", (int)Sessions.size(), Sessions.size() > 1 ? "s" : ""), LogLevelInfo);
 	
 	string input;
 	while (true)
@@ -176,223 +100,46 @@ void RunFileData()
 		toUpper(input);
 		
 		if (!ProcessKeyboardInput(input))
-		{
-			DemoFileReader.Cancel();
 			break;
-		}
 	}
-}
-
-
-//  Handle samples from the data source
-void OnNewSample(BFSample* sample)
-{
-	if (IsRecording())
-		FileWriter->AddData(sample->Copy());
-
-	//  broadcast it
-	DataBroadcaster.AddData(sample);
-}
-
-
-//  Handle callback from data source when board connection state changed
-//  this will set the status lights for any board transition
-//  and for new board discovery, call SetBoard( ) on the data source now that the sample rate is known
-//
-void OnBoardConnectionStateChanged(BoardConnectionStates state, int boardId, int sampleRate)
-{
-	switch (state) 
-	{
-	case New:	
-		{
-			BoardId = boardId;
-			DataBroadcaster.SetBoard(boardId, sampleRate);
-			StatusBroadcaster.StartBroadcast(boardId, sampleRate);
-		}
-		break;
-		
-	case Connected:	
-		{
-			ConnectionLightShowReady();
-		}
-		break;
-		
-	case Disconnected: 
-		{
-			ConnectionLightShowConnecting();
-		}
-		break;
-		
-	case StreamOn:
-		{
-			if (DataBroadcaster.HasClients())
-				ConnectionLightShowConnected();
-			else
-				ConnectionLightShowReady();
-		}
-		break;
-		
-	case StreamOff:
-		{
-			ConnectionLightShowPaused();
-		}
-		break;
-		
-	case PowerOff:	//  power Off board
-		{
-		}
-		break;
-		
-	case PowerOn:	//  power on board
-		{
-		}
-		break;
-	}
-}
-
+	
+	//  shut down LED lights
+	StopGpioController();
 
-// Handle callback from LSL broadcaster regarding client connections
-//
-void OnLslConnectionStateChanged(bool state)
-{
-	if (state)
-	{
-		ConnectionLightShowConnected();
-	}
-	else if (DataSource->GetIsStreamRunning())
-	{
-		ConnectionLightShowReady();
-	}
-	else if (DataSource->GetIsConnected())
-	{
-		ConnectionLightShowPaused();
-	}
-	else
+	// user quit, stop the command server before the sessions it uses, then stop threads
+	ComServer.Cancel();
+	
+	for (auto it = Sessions.begin(); it != Sessions.end(); ++it)
 	{
-		ConnectionLightShowConnecting();
+		(*it)->Stop();
+		delete *it;
 	}
-}
-
-
-// Handle callback from file recorder on the state of the recording file
-//
-void OnRecordingStateChanged(bool recording)
-{
-	RecordingLight(recording);
-}
-
-
-
-//  Handle request to start/stop recording
-//
-bool HandleRecordingRequest(UriArgParser& requestParser)
-{
-	if (DataSource != NULL)
-	{
-		auto fileName = requestParser.GetArg("filename");
-		auto enable = requestParser.GetArg("enable");
+	Sessions.clear();
 	
-		if (enable == "true")
-		{
-			if (FileWriter != NULL)
-			{
-				FileWriter->Cancel();
-				delete FileWriter;
-				FileWriter = NULL;
-			}
-			
-			auto formatType = requestParser.GetArg("format");
-			
-			FileHeaderInfo info;
-			info.SubjectName = requestParser.GetArg("name");
-			info.SubjectCode = requestParser.GetArg("code");
-			info.SubjectBirthday = requestParser.GetArg("birthday");
-			info.SubjectAdditional = requestParser.GetArg("additional");
-			info.SubjectGender = requestParser.GetArg("gender");
-			info.AdminCode = requestParser.GetArg("admin");
-			info.Technician = requestParser.GetArg("tech");
-			
-			int format = 1;
-			if (formatType.compare("txt") == 0)
-				format = 0;
-			
-			switch (format)
-			{
-			case 0:
-				FileWriter = new OpenBCIFileWriter(OnRecordingStateChanged);
-				break;
-			case 1:
-				FileWriter = new BDFFileWriter(OnRecordingStateChanged);
-				break;
-				
-			default :
-				return false;
-			}
-			
-			
-			FileWriter->StartRecording(fileName, RecordToUsb, BoardId, DataSource->GetSampleRate(), info);
-		}
-		else if (enable == "false")
-		{
-			if (IsRecording())
-			{
-				FileWriter->Cancel();
-				delete FileWriter;
-				FileWriter = NULL;
-			}
-		}
-		
-		return true;
-	}
+	Logging.Cancel();
 	
-	return false;
+	return 0;
 }
 
 
-//  Handle request to set SRB1
+//  Find the session for a device name
+//  an empty name selects the primary session
 //
-bool HandleSrbSetRequest(UriArgParser& requestParser)
+BoardSession* FindSession(string device)
 {
-	auto enable = requestParser.GetArg("enable");
-	toUpper(enable);
-	int board = ParseInt(requestParser.GetArg("board"));
-	if (enable == "TRUE" && board > -1)
-	{
-		DataSource->RequestSetSrb1(board, true);
-	}
-	else if (enable == "FALSE" && board > -1)
-	{
-		DataSource->RequestSetSrb1(board, false);
-	}
-	else
-	{
-		return false;
-	}
+	if (Sessions.size() == 0)
+		return NULL;
 	
-	return true;
-}
-
-
-//  Handle request to start / stop stream
-//
-bool HandleSetStreamRequest(UriArgParser& requestParser)
-{
-	auto enable = requestParser.GetArg("enable");
-	toUpper(enable);
-	if (enable == "TRUE")
-	{
-		DataSource->RequestEnableStreaming(true);
-	}
-	else if (enable == "FALSE")
-	{
-		DataSource->RequestEnableStreaming(false);
-	}
-	else
+	if (device.size() == 0)
+		return Sessions.front();
+	
+	for (auto it = Sessions.begin(); it != Sessions.end(); ++it)
 	{
-		return false;
+		if ((*it)->GetDevice() == device)
+			return *it;
 	}
 	
-	return true;
+	return NULL;
 }
 
 
@@ -425,27 +172,40 @@ bool HandleSetTimeRequest(UriArgParser& requestParser)
 	
 
 //  Handle callback from ComServer to process a request
+//  board requests go to the session named by the device argument, or the primary session if there is none
 //
 bool OnServerRequest(string request)
 {
 	UriArgParser requestParser(request);
 	
+	if (requestParser.GetRequest() == "settime")
+	{
+		return HandleSetTimeRequest(requestParser);	
+	}
+	
+	auto session = FindSession(requestParser.GetArg("device"));
+	if (session == NULL)
+	{
+		Logging.AddLog("main", "OnServerRequest", format("No board for request %s",request.c_str()), LogLevelWarn);
+		return false;
+	}
+	
 	if (requestParser.GetRequest() == "recording")
 	{
 		//  request to start recording
-		return HandleRecordingRequest(requestParser);
+		return session->HandleRecordingRequest(requestParser, RecordToUsb);
 	}
 	else if (requestParser.GetRequest() == "srbset")
 	{
-		return HandleSrbSetRequest(requestParser);
+		return session->HandleSrbSetRequest(requestParser);
 	}
 	else if (requestParser.GetRequest() == "streamset")
 	{
-		return HandleSetStreamRequest(requestParser);
+		return session->HandleSetStreamRequest(requestParser);
 	}
-	else if (requestParser.GetRequest() == "settime")
+	else if (requestParser.GetRequest() == "channelset")
 	{
-		return HandleSetTimeRequest(requestParser);	
+		return session->HandleChannelSetRequest(requestParser);
 	}
 	else
 	{
@@ -455,10 +215,12 @@ bool OnServerRequest(string request)
 }
 
 
-//  Process keyboard input from the board read / demo file run loop
+//  Process keyboard input from the run loop
 //
 bool ProcessKeyboardInput(string input)
 {
+	auto primary = FindSession("");
+	
 	if (input.compare("Q") == 0) 
 	{
 		return false;
@@ -469,20 +231,25 @@ bool ProcessKeyboardInput(string input)
 	}
 	else if (input.compare("B") == 0)
 	{
-		DataSource->EnableBoard(!DataSource->Enabled());
+		for (auto it = Sessions.begin(); it != Sessions.end(); ++it)
+		{
+			auto dataSource = (*it)->GetDataSource();
+			if (dataSource != NULL)
+				dataSource->EnableBoard(!dataSource->Enabled());
+		}
 	}
-	else if (input.compare("C") == 0 && DataSource != NULL)
+	else if (input.compare("C") == 0 && primary != NULL && primary->GetDataSource() != NULL)
 	{
 		if (Logging.IsDisplayOutputEnabled())
 		{
 			
 			Logging.PauseDisplayOutput();
-			DataSource->EnableRawConsole(true);
+			primary->GetDataSource()->EnableRawConsole(true);
 		}
 		else
 		{
 			Logging.ResumeDisplayOutput();
-			DataSource->EnableRawConsole(false);
+			primary->GetDataSource()->EnableRawConsole(false);
 		}
 	}
 	
@@ -492,9 +259,9 @@ bool ProcessKeyboardInput(string input)
 
 //  Check if board ID is supported by the program
 //
-bool SupportedBoard()
+bool SupportedBoard(int boardId)
 {
-	switch ((BrainhatBoardIds)BoardId)
+	switch ((BrainhatBoardIds)boardId)
 	{
 	default:
 		return false;
@@ -502,52 +269,66 @@ bool SupportedBoard()
 	case BrainhatBoardIds::MENTALIUM:
 	case BrainhatBoardIds::CYTON_BOARD:
 	case BrainhatBoardIds::CYTON_DAISY_BOARD:
+	case BrainhatBoardIds::CONTEC:
+	case BrainhatBoardIds::SIGNAL_GENERATOR:
 		return true;
 	}
 }
 
 
 //  Parse the command line arguments for the brainHat program
+//  with no arguments, the default is one Cyton board on the default port
 //
 bool ParseArguments(int argc, char *argv[])
 {
-	if (argc > 1)
+	//  parse the args
+	if(argc > 1 && !parse_args(argc, argv))
+	{
+		cout << "Invalid startup parameters. Exiting program." << endl;
+		getchar();
+		return false;
+	}
+	
+	for (auto it = BoardSettings.begin(); it != BoardSettings.end(); ++it)
 	{
-		//  parse the args
-		if(!parse_args(argc, argv))
-		{
-			cout << "Invalid startup parameters. Exiting program." << endl;
-			getchar();
-			return false;
-		}
-		
 		//  for file data, check demo file name
-		if(LiveData() && DemoFileName.size() > 0 )
+		if(it->LiveData() && it->DemoFileName.size() > 0 )
 		{
-			BoardId = (int)BrainhatBoardIds::UNDEFINED;
+			it->BoardId = (int)BrainhatBoardIds::UNDEFINED;
 		}
 		
 		//  for live data, check supported boards
-		if(LiveData() && !SupportedBoard())
+		if(it->LiveData() && !SupportedBoard(it->BoardId))
 		{
 			cout << "Invalid startup parameters. This board is not supported. Exiting program." << endl;
 			getchar();
 			return false;
 		}
 		
+		//  the serial reader decodes Cyton packets only
+		if(it->LiveData() && it->NativeSerial && !IsCytonFamily(it->BoardId))
+		{
+			cout << "Invalid startup parameters. The serial reader only supports the Cyton boards. Exiting program." << endl;
+			getchar();
+			return false;
+		}
+		
 		//  default serial port if it was not specified
-		if(LiveData() && InputParams.serial_port.size() == 0)
-			InputParams.serial_port = "/dev/ttyUSB0";
-	}
-	else
-	{
-		// no command line args,  default to Cyton board on the default port
-		BoardId = (int)BrainhatBoardIds::CYTON_BOARD;
-		InputParams.serial_port = "/dev/ttyUSB0";
+		if(it->LiveData() && it->InputParams.serial_port.size() == 0)
+			it->InputParams.serial_port = "/dev/ttyUSB0";
+		
+		//  each board needs its own name to be selected by requests
+		for (auto other = BoardSettings.begin(); other != it; ++other)
+		{
+			if (other->Device == it->Device)
+			{
+				cout << "Invalid startup parameters. Each board needs a different --device name. Exiting program." << endl;
+				getchar();
+				return false;
+			}
+		}
 	}
 	
-	
-	
 	return true;
 }
 
@@ -556,14 +337,37 @@ bool ParseArguments(int argc, char *argv[])
 //
 bool parse_args(int argc, char *argv[])
 {
+	//  boards that asked for the time stamp channel, it is only sent with the double lsl format
+	std::vector<size_t> timeStampChannelBoards;
+	
 	for (int i = 1; i < argc; i++)
 	{
+		//  board settings apply to the board from the last --device
+		BoardSessionSettings* board = &BoardSettings.back();
+		
+		if (std::string(argv[i]) == std::string("--device"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (NamedBoards > 0)
+					BoardSettings.push_back(BoardSessionSettings());
+				BoardSettings.back().Device = std::string(argv[i]);
+				NamedBoards++;
+				continue;
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
 		if (std::string(argv[i]) == std::string("--board-id"))
 		{
 			if (i + 1 < argc)
 			{
 				i++;
-				BoardId = std::stoi(std::string(argv[i]));
+				board->BoardId = std::stoi(std::string(argv[i]));
 			}
 			else
 			{
@@ -576,7 +380,102 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				DemoFileName = std::string(argv[i]);
+				board->DemoFileName = std::string(argv[i]);
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--playback"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (!ParseFilePlaybackMode(std::string(argv[i]), board->Playback))
+				{
+					std::cerr << "invalid playback, use realtime, max or virtual" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--playback-speed"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->PlaybackSpeed = std::stod(std::string(argv[i]));
+				if (board->PlaybackSpeed <= 0.0)
+				{
+					std::cerr << "invalid playback speed" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--playback-tick"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->PlaybackTickMs = std::stoi(std::string(argv[i]));
+				if (board->PlaybackTickMs <= 0)
+				{
+					std::cerr << "invalid playback tick" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--generator"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				Parser parser(std::string(argv[i]), ",");
+				board->BoardId = (int)BrainhatBoardIds::SIGNAL_GENERATOR;
+				board->Generator.ExgChannels = parser.GetNextInt();
+				board->Generator.SampleRate = parser.GetNextInt();
+				if (board->Generator.ExgChannels <= 0 || board->Generator.SampleRate <= 0)
+				{
+					std::cerr << "invalid generator, use channels,rate" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--generator-signal"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				Parser parser(std::string(argv[i]), ",");
+				board->Generator.SineAmplitude = parser.GetNextDouble();
+				board->Generator.NoiseAmplitude = parser.GetNextDouble();
+				board->Generator.ArtifactInterval = parser.GetNextDouble();
+				if (board->Generator.SineAmplitude < 0.0 || board->Generator.NoiseAmplitude < 0.0 || board->Generator.ArtifactInterval < 0.0)
+				{
+					std::cerr << "invalid generator signal, use sine uV,noise uV,artifact interval seconds" << std::endl;
+					return false;
+				}
 			}
 			else
 			{
@@ -590,7 +489,7 @@ bool parse_args(int argc, char *argv[])
 			{
 				i++;
 				if (std::string(argv[i]) == "true")
-					StartSrbOn = true;
+					board->StartSrbOn = true;
 			}
 			else
 			{
@@ -617,7 +516,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.ip_address = std::string(argv[i]);
+				board->InputParams.ip_address = std::string(argv[i]);
 			}
 			else
 			{
@@ -630,7 +529,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.ip_port = std::stoi(std::string(argv[i]));
+				board->InputParams.ip_port = std::stoi(std::string(argv[i]));
 			}
 			else
 			{
@@ -643,7 +542,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.serial_port = std::string(argv[i]);
+				board->InputParams.serial_port = std::string(argv[i]);
 			}
 			else
 			{
@@ -656,7 +555,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.ip_protocol = std::stoi(std::string(argv[i]));
+				board->InputParams.ip_protocol = std::stoi(std::string(argv[i]));
 			}
 			else
 			{
@@ -669,7 +568,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.timeout = std::stoi(std::string(argv[i]));
+				board->InputParams.timeout = std::stoi(std::string(argv[i]));
 			}
 			else
 			{
@@ -682,7 +581,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.other_info = std::string(argv[i]);
+				board->InputParams.other_info = std::string(argv[i]);
 			}
 			else
 			{
@@ -695,7 +594,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.mac_address = std::string(argv[i]);
+				board->InputParams.mac_address = std::string(argv[i]);
 			}
 			else
 			{
@@ -708,7 +607,7 @@ bool parse_args(int argc, char *argv[])
 			if (i + 1 < argc)
 			{
 				i++;
-				InputParams.serial_number = std::string(argv[i]);
+				board->InputParams.serial_number = std::string(argv[i]);
 			}
 			else
 			{
@@ -729,6 +628,301 @@ bool parse_args(int argc, char *argv[])
 				return false;
 			}
 		}
+		if (std::string(argv[i]) == std::string("--read-target"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (!ParseBoardReadTarget(std::string(argv[i]), board->ReadMode, board->ReadMinBatch))
+				{
+					std::cerr << "invalid read target, use latency, balanced or cpu" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--read-batch"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->ReadMode = ReadAdaptive;
+				board->ReadMinBatch = std::stoi(std::string(argv[i]));
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--gap-fill"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (!ParseSampleGapFill(std::string(argv[i]), board->GapFill))
+				{
+					std::cerr << "invalid gap fill, use none, nan or interpolate" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--reader"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (std::string(argv[i]) == std::string("serial"))
+					board->NativeSerial = true;
+				else if (std::string(argv[i]) == std::string("brainflow"))
+					board->NativeSerial = false;
+				else
+				{
+					std::cerr << "invalid reader, use brainflow or serial" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--lsl-queue"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->LslQueueCapacity = std::stoi(std::string(argv[i]));
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--lsl-chunk-ms"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->LslChunkMs = std::stoi(std::string(argv[i]));
+				if (board->LslChunkMs <= 0)
+				{
+					std::cerr << "invalid lsl chunk duration" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--lsl-format"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (!ParseLslEncoding(std::string(argv[i]), board->LslFormat))
+				{
+					std::cerr << "invalid lsl format, use double, float32 or int32" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--lsl-timestamp"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (std::string(argv[i]) == std::string("channel"))
+				{
+					board->LslTimeStampChannel = true;
+					timeStampChannelBoards.push_back(BoardSettings.size() - 1);
+				}
+				else if (std::string(argv[i]) == std::string("lsl"))
+					board->LslTimeStampChannel = false;
+				else
+				{
+					std::cerr << "invalid lsl time stamp, use channel or lsl" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--derived-filter"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				Parser parser(std::string(argv[i]), ",");
+				board->Derived.Filtered = true;
+				board->Derived.HighPassHz = parser.GetNextDouble();
+				board->Derived.LowPassHz = parser.GetNextDouble();
+				if (board->Derived.HighPassHz <= 0.0 || board->Derived.LowPassHz <= board->Derived.HighPassHz)
+				{
+					std::cerr << "invalid derived filter, use low,high" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--derived-notch"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->Derived.NotchHz = std::stod(std::string(argv[i]));
+				if (board->Derived.NotchHz < 0.0)
+				{
+					std::cerr << "invalid derived notch, use frequency or 0 for none" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--derived-decimate"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->Derived.DecimatedRate = std::stoi(std::string(argv[i]));
+				if (board->Derived.DecimatedRate <= 0)
+				{
+					std::cerr << "invalid derived decimated rate" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--derived-bandpower"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->Derived.BandPowerIntervalMs = std::stoi(std::string(argv[i]));
+				if (board->Derived.BandPowerIntervalMs <= 0)
+				{
+					std::cerr << "invalid derived band power interval" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--derived-bands"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				std::vector<std::string> bands;
+				Tokenize(std::string(argv[i]), bands, ",");
+				board->Derived.Bands.clear();
+				for (auto band : bands)
+				{
+					Parser parser(band, "-");
+					double low = parser.GetNextDouble();
+					double high = parser.GetNextDouble();
+					if (low < 0.0 || high <= low)
+					{
+						std::cerr << "invalid derived bands, use low-high,low-high" << std::endl;
+						return false;
+					}
+					board->Derived.Bands.push_back(std::make_pair(low, high));
+				}
+				if (board->Derived.Bands.size() == 0)
+				{
+					std::cerr << "invalid derived bands, use low-high,low-high" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--lsl-policy"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (!ParseSampleBusOverflowPolicy(std::string(argv[i]), board->LslQueuePolicy))
+				{
+					std::cerr << "invalid queue policy, use block, dropoldest, dropnewest or decimate" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--rec-queue"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				board->RecordingQueueCapacity = std::stoi(std::string(argv[i]));
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
+		if (std::string(argv[i]) == std::string("--rec-policy"))
+		{
+			if (i + 1 < argc)
+			{
+				i++;
+				if (!ParseSampleBusOverflowPolicy(std::string(argv[i]), board->RecordingQueuePolicy))
+				{
+					std::cerr << "invalid queue policy, use block, dropoldest, dropnewest or decimate" << std::endl;
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "missed argument" << std::endl;
+				return false;
+			}
+		}
 		if (std::string(argv[i]) == std::string("--pin-rec"))
 		{
 			if (i + 1 < argc)
@@ -744,6 +938,15 @@ bool parse_args(int argc, char *argv[])
 		}
 	}
 	
+	for (auto it = timeStampChannelBoards.begin(); it != timeStampChannelBoards.end(); ++it)
+	{
+		if (BoardSettings[*it].LslFormat != LslDouble64)
+		{
+			std::cerr << "invalid lsl time stamp, channel is only sent with the double lsl format" << std::endl;
+			return false;
+		}
+	}
+	
 	return true;
 }
 
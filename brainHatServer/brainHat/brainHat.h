@@ -1,14 +1,4 @@
 #pragma once
-#include "BroadcastData.h"
-#include "BoardDataReader.h"
 #include "Logger.h"
-#include "OpenBCIFileWriter.h"
 
 extern Logger Logging;
-
-
-extern BoardDataSource* DataSource;
-extern BrainHatFileWriter* FileWriter;
-
-
-